@@ -4,6 +4,14 @@
 #include <string.h>
 #include <math.h>
 #include <time.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
 
 #define MAX_ENEMIES 1000
 #define MAX_PROJECTILES 1000
@@ -13,7 +21,48 @@
 #define SCREEN_WIDTH 1200
 #define SCREEN_HEIGHT 600
 #define MAX_NOME 50
+#define PLAYER_MAX_HEALTH 3     // Vida ao comecar, o HUD tem espaco para esse numero de coracoes
 #define MAX_HISTORY_SIZE 180
+#define TILE_WORDS ((MAX_WIDTH + 63) / 64) // Palavras de 64 bits por linha de cada camada de tiles
+#define MAX_MERGED_RECTS 4096
+#define MAX_CHECKPOINTS 64
+#define ENTITY_WORDS ((MAX_WIDTH + 63) / 64) // Palavras de 64 bits dos conjuntos de bits de inimigos e moedas
+#define SFX_VOICES 4            // Copias de cada efeito sonoro que podem tocar ao mesmo tempo
+#define SFX_QUEUE_SIZE 64       // Pedidos de efeito pendentes entre o jogo e a thread de audio
+#define SFX_SAMPLE_RATE 22050
+#define PAK_FILE "assets.pak"   // Assets pre-decodificados gerados com --bake
+#define PAK_VERSION 1
+#define PAK_NAME_SIZE 32
+#define PAK_MAX_IMAGE_SIZE 8192 // Maior largura ou altura aceita de uma imagem do pacote
+#define MAX_PARTICLES 8192      // Capacidade do pool de particulas: um lote padrao do rlgl (8192 retangulos), multiplo de 4 para o laco vetorial
+#define SAVE_FILE "quicksave.bin"   // Gravado com F5, carregado com F9
+#define SAVE_VERSION 3
+#define INPUT_QUEUE_SIZE 64     // Teclas apertadas esperando para serem consumidas pela simulacao
+#define INPUT_EVENT_MAX_AGE 0.25 // Segundos que um evento pode esperar na fila antes de ser descartado
+#define SIM_TICK (1.0f / 120.0f) // Passo fixo da simulacao na janela, igual ao maior subpasso da fisica
+#define SIM_MAX_TICKS 8         // Passos por frame no maximo: depois de um travamento o jogo desacelera em vez de acumular atraso
+#define PACER_HISTORY 120           // Frames usados nas medias do controle de ritmo
+#define PACER_ADAPT_FRAMES 30       // Frames recentes avaliados antes de o modo adaptativo trocar de limite
+#define PACER_SPIN_MARGIN 0.002     // Ultimos segundos da espera feitos em laco ativo, dormir nao e preciso o bastante
+#define LEVEL_ARENA_SIZE (2 * 1024 * 1024) // Bytes reservados uma vez para tudo que vive enquanto o nivel esta carregado
+#define ARENA_ALIGN 16
+#define FLOW_MAX_DISTANCE 48    // Tiles percorridos pela busca do campo de fluxo a partir do jogador, inimigos mais longe nao perseguem
+#define FLOW_QUEUE_SIZE ((2 * FLOW_MAX_DISTANCE + 1) * MAX_HEIGHT) // Colunas alcancaveis x linhas do mapa
+#define TILE_EDIT_QUEUE_SIZE 256 // Trocas de tile pendentes ate o proximo CommitLevelEdits
+#define MAX_BROKEN_TILES 4096   // Blocos quebrados lembrados para voltar no reinicio e ir no quicksave
+#define MAP_POLL_INTERVAL 0.5   // Segundos entre consultas da data de modificacao do mapa, quando nao ha inotify
+#define FX_SHIFT 16                     // Ponto fixo 16.16: 16 bits de parte inteira e 16 de fracao
+#define FX_ONE (1 << FX_SHIFT)
+#define FX_MAX_COORD (16384 << FX_SHIFT) // Limites do modo de ponto fixo, mantem somas de posicao e deslocamento dentro de 32 bits
+#define FX_MAX_SPEED (4096 << FX_SHIFT)
+#define FX_MAX_FRAME (FX_ONE / 4)
+
+typedef int32_t fixed_t;
+
+typedef struct {
+    fixed_t x;
+    fixed_t y;
+} FixedVec2;
 
 typedef struct {
     Vector2 position;   // Coordenadas (x, y)
@@ -27,21 +76,63 @@ typedef struct {
     char nome[MAX_NOME];// Nome salvo no leaderbord
     Vector2 spawnPoint; // Spawnpoint definido no mapa
     int hasFinished;    // Determina se o jogador terminou o jogo
+    float shootTimer;   // Tempo desde o ultimo tiro, para a animacao de atirar
+    FixedVec2 fxPosition; // Posicao em ponto fixo, usada no lugar de position quando config.fixedPoint esta ligado
+    FixedVec2 fxVelocity; // Velocidade em ponto fixo
+    float jumpBuffer;   // Tempo restante de um pulo apertado antes de tocar o chao
+    float coyoteTimer;  // Tempo restante para ainda poder pular depois de sair do chao
 } Player;
 
+// Comandos do jogador em um passo da simulacao, lidos do teclado ou gerados por um bot
+typedef struct {
+    bool left;          // Seta esquerda segurada
+    bool right;         // Seta direita segurada
+    bool jump;          // Espaco apertado neste passo
+    bool shoot;         // Z apertado neste passo (tiro horizontal)
+    bool shootVertical; // X apertado neste passo (tiro vertical)
+} PlayerInput;
+
+// Acoes de aperto unico que passam pela fila de entrada
+typedef enum {
+    INPUT_JUMP,
+    INPUT_SHOOT,
+    INPUT_SHOOT_VERTICAL
+} InputAction;
+
+typedef struct {
+    double time;        // Momento em que a tecla foi lida (GetTime)
+    InputAction action;
+} InputEvent;
+
+// Fila circular de apertos de tecla. Cada passo da simulacao consome no maximo um aperto de cada acao, entao dois apertos da mesma acao viram duas acoes em passos seguidos
+typedef struct {
+    InputEvent events[INPUT_QUEUE_SIZE];
+    int head;           // Evento mais antigo
+    int count;
+} InputQueue;
+
 typedef struct {
     char nome[MAX_NOME];
     int points;
 } JogadorLeader;
 
+typedef enum {
+    ENEMY_PATROL,       // 'M' vai e volta na horizontal
+    ENEMY_FLYER         // 'F' voa atras do jogador pelo campo de fluxo
+} EnemyKind;
+
 typedef struct {
     Vector2 position;   // coordenadas (x, y)
     Vector2 velocity;   // velocidade (x, y)
     Rectangle rect;     // Retangulo pra colisao
+    EnemyKind kind;
     Vector2 minPosition; // posicao minima (x, y)
     Vector2 maxPosition; // posicao maxima (x, y)
     int health;         // pontos de vida
     bool active;        // determina se o inimigo está ativo
+    unsigned char animPhase; // deslocamento do quadro em relacao ao relogio de animacao compartilhado
+    FixedVec2 fxPosition; // posicao em ponto fixo (modo config.fixedPoint)
+    FixedVec2 fxVelocity; // velocidade em ponto fixo
 } Enemy;
 
 typedef struct {
@@ -49,12 +140,13 @@ typedef struct {
     Vector2 speed;   // Velocidade do projétil
     bool active;     // Indica se o projétil está ativo
     Color color;    // Cor do projetil
+    FixedVec2 fxPosition; // Posicao em ponto fixo (modo config.fixedPoint)
+    FixedVec2 fxSpeed;    // Velocidade em ponto fixo
 } Projectile;
 
 typedef struct {
     Vector2 position;   // Coordenadas (x, y)
     Rectangle rect;     // Retângulo para colisão
-    bool active;        // Se a moeda está ativa ou não
     int points;         // Quantidade de pontos que a moeda dá
 } Coin;
 
@@ -74,6 +166,11 @@ typedef struct {
     float projectileHeight;
     float projectileSpeed;
     float frameSpeed;
+    float maxSubstepTime;   // Maior intervalo de tempo simulado em um subpasso da fisica do jogador
+    int maxSubsteps;        // Orcamento de subpassos por frame, acima disso o frame e dividido igualmente
+    float jumpBufferTime;   // Pulo apertado ate este tempo antes de tocar o chao ainda acontece ao tocar
+    float coyoteTime;       // Pulo ainda vale ate este tempo depois de sair da beira de uma plataforma
+    bool fixedPoint;        // Move jogador, inimigos e projeteis com inteiros 16.16, com resultado identico em qualquer compilador e maquina
 } GameConfig;
 
 typedef struct {
@@ -92,30 +189,520 @@ typedef struct {
 } GameAssets;
 
 
+// Camadas de propriedades dos tiles, cada uma guarda 1 bit por tile do mapa
+typedef enum {
+    TILE_SOLID,         // 'B' bloco solido
+    TILE_HAZARD,        // 'O' obstaculo que causa dano
+    TILE_GATE,          // 'G' portao de saida
+    TILE_COLLECTABLE,   // 'C' moeda
+    TILE_CHECKPOINT,    // 'K' ponto de controle
+    TILE_BREAKABLE,     // 'D' bloco que quebra com um tiro, tambem esta em TILE_SOLID
+    TILE_LAYER_COUNT
+} TileLayer;
+
+typedef struct {
+    uint64_t (*bits[TILE_LAYER_COUNT])[TILE_WORDS]; // rows linhas por camada, num bloco so da arena. Bit x%64 da palavra x/64 indica se o tile (x, y) tem a propriedade
+    int rows;                                       // Linhas alocadas em cada camada
+} TileFlags;
+
+typedef struct {
+    Rectangle rect;     // Area coberta pelos tiles unidos (em pixels)
+    int tilesX;         // Quantidade de tiles na horizontal
+    int tilesY;         // Quantidade de tiles na vertical
+} TileRect;
+
+// Troca de tile pedida durante a partida, aplicada no proximo CommitLevelEdits
+typedef struct {
+    int16_t x;
+    int16_t y;
+    char tile;
+} TileEdit;
+
+// Entidades do nivel logo depois de carregado, copiadas de volta em bloco a cada reinicio
+typedef struct {
+    Enemy *enemies;
+    int enemyCount;
+    int enemyCapacity;
+    Coin *coins;
+    int coinCount;
+    int coinCapacity;
+    Vector2 spawnPoint;
+} LevelSnapshot;
+
+// Ponto de controle: guarda so o que mudou desde o inicio do nivel (inimigos mortos e moedas coletadas), o resto vem do LevelSnapshot
+typedef struct {
+    bool active;
+    Vector2 spawnPoint;                 // Onde o jogador volta a aparecer
+    int points;                         // Pontos no momento do checkpoint
+    uint64_t deadEnemies[ENTITY_WORDS]; // Bit i: inimigo i ja estava morto
+    uint64_t takenCoins[ENTITY_WORDS];  // Bit i: moeda i ja tinha sido coletada
+    int32_t brokenTiles;                // Blocos quebrados ate o checkpoint (inicio do registro do nivel)
+} LevelCheckpoint;
+
+// Memoria linear: alocar so avanca um indice e tudo e liberado de uma vez ao trocar de nivel
+typedef struct {
+    unsigned char *base;
+    size_t size;        // Capacidade em bytes, reservada uma vez so
+    size_t used;        // Bytes ja entregues, contando o alinhamento
+    size_t highWater;   // Maior valor de used desde a criacao
+    size_t last;        // Inicio da ultima alocacao, a unica que pode mudar de tamanho no lugar
+} Arena;
+
+// Dados do nivel carregado. Durante a partida so mudam os blocos quebraveis (EditLevelTile), entao cada instancia do jogo precisa da sua copia (CopyLevel).
+// Tudo que os ponteiros apontam vem da arena, com o tamanho do nivel lido, e some junto no proximo LoadLevel
+typedef struct {
+    Arena *arena;
+    const char *fileName;
+    char (*map)[MAX_WIDTH];     // mapRows linhas alocadas, rows delas em uso
+    int mapRows;
+    TileFlags *tiles;           // Camadas de bits geradas a partir do mapa
+    int rows;
+    int cols;
+    TileRect *solidRects;       // Blocos unidos em retangulos, usados na colisao e no desenho. Depois dos fixos, um 1x1 por bloco quebravel
+    int solidRectCount;
+    int solidRectCapacity;
+    int staticSolidRectCount;   // Retangulos de blocos fixos, so mudam quando o mapa muda
+    int16_t *breakableRect;     // Indice em solidRects de cada bloco quebravel (linha * breakableRectCols + coluna), so existe se o nivel tem 'D'
+    int breakableRectRows;      // Linhas e colunas do nivel quando o indice foi montado
+    int breakableRectCols;
+    int breakableRectCapacity;  // Posicoes alocadas, cresce quando um mapa recarregado fica maior
+    TileRect *hazardRects;      // Obstaculos unidos em retangulos, usados no desenho
+    int hazardRectCount;
+    int hazardRectCapacity;
+    TileRect *gateRects;        // Portoes unidos em retangulos, usados no desenho
+    int gateRectCount;
+    int gateRectCapacity;
+    Vector2 *checkpoints;       // Posicao dos tiles 'K', usados no desenho (ate MAX_CHECKPOINTS)
+    int checkpointCount;
+    int (*coinRank)[TILE_WORDS]; // Moedas antes de cada palavra da camada TILE_COLLECTABLE, na ordem de leitura: indice da moeda de um tile sem percorrer o vetor
+    int coinRankRows;
+    TileEdit *edits;            // Trocas de tile pendentes (lista suja), TILE_EDIT_QUEUE_SIZE
+    int editCount;
+    uint32_t *brokenTiles;      // Registro dos blocos quebrados desde o inicio, (y << 16) | x
+    int brokenCount;
+    int brokenCapacity;
+    uint32_t hash;              // LevelHash do mapa sem blocos quebrados, identifica o nivel no quicksave
+    uint32_t *flowCells;        // Celulas do campo de fluxo da partida (FlowField), rows * cols
+    Enemy *enemies;             // Inimigos da partida em andamento (GameState.enemies), initial.enemyCapacity
+    int flowCellCapacity;
+    LevelSnapshot initial;                  // Entidades como estavam ao carregar o nivel
+} Level;
+
+// Distancia em tiles de cada tile livre ate o jogador (busca em largura), compartilhada por todos os inimigos que perseguem
+typedef struct {
+    uint32_t *cells;            // rows * cols, na arena do nivel: (geracao << 16) | distancia. Geracao diferente da atual: tile nao alcancado
+    int rows;
+    int cols;
+    uint32_t generation;        // Trocar a geracao invalida o campo inteiro sem limpar cells
+    int originX;                // Tile do jogador na ultima busca, -1 forca uma busca nova
+    int originY;
+    uint32_t queue[FLOW_QUEUE_SIZE]; // Fila da busca, (y << 16) | x
+} FlowField;
+
 typedef struct {
+    Level *level;               // Nivel sendo jogado
     Player player;
     Camera2D camera;
-    Coin coins[MAX_WIDTH];
-    int coinCount;
-    Enemy enemies[MAX_WIDTH];
+    uint64_t activeCoins[ENTITY_WORDS]; // Bit i: moeda i do nivel ainda nao coletada. Moedas nao se mexem, o resto vem de level->initial.coins
+    Enemy *enemies;             // Level.enemies: copia viva de level->initial.enemies, com os mesmos indices
     int enemyCount;
+    FlowField flow;             // Caminho ate o jogador, refeito so quando ele muda de tile
     Projectile projectiles[MAX_PROJECTILES];
     float frameTimer;           // Frame para identificar sprite do jogador
     float frameTimerEnemies;    // Frame para trocar sprite do jogador
     unsigned currentFrame;      // Frame para identificar sprite do inimigo
     unsigned currentEnemyFrame; // Frame para trocar sprite do inimigo
-    int guarda; // Guarda a opção do jogador no menu
-    char map[MAX_HEIGHT][MAX_WIDTH];
-    int rows;
-    int cols;
+    int guarda; // Tela atual (Scene)
+    LevelCheckpoint checkpoint;             // Ultimo checkpoint alcancado
+    InputQueue input;                       // Apertos de tecla ainda nao consumidos pela simulacao
+    float tickAccumulator;                  // Tempo de jogo ainda nao simulado, menos de um SIM_TICK depois de cada frame
 } GameState;
 
-// Le o mapa a partir de um arquivo
-void LoadMap(const char* filename, char map[MAX_HEIGHT][MAX_WIDTH], int* rows, int* cols) {
+// Modos do controle de ritmo dos frames
+typedef enum {
+    PACE_CAP,           // Limite fixo em targetFps, espera medida pelo proprio jogo
+    PACE_VSYNC,         // Espera a sincronia vertical do monitor
+    PACE_UNCAPPED,      // Sem espera nenhuma
+    PACE_ADAPTIVE,      // Limite em targetFps, cai para a metade quando os frames nao cabem e volta quando sobra tempo
+    PACE_MODE_COUNT
+} PaceMode;
+
+typedef struct {
+    PaceMode mode;
+    int targetFps;                      // Limite dos modos PACE_CAP e PACE_ADAPTIVE
+    int currentFps;                     // Limite em uso (no adaptativo pode ser targetFps / 2)
+    double frameStart;                  // Fim da espera do frame anterior, comeco do trabalho deste
+    double pollTime;                    // Quando os eventos de entrada foram lidos do sistema pela ultima vez
+    bool inputUsed;                     // A simulacao deste frame consumiu a entrada lida em pollTime
+    float frameTime;                    // Duracao do ultimo frame, o passo de tempo do frame seguinte
+    float intervals[PACER_HISTORY];     // Duracao dos ultimos frames, do fim de uma espera ao fim da outra
+    float work[PACER_HISTORY];          // Trabalho dos ultimos frames (atualizar e desenhar), sem a espera
+    int historyIndex;
+    int historyCount;
+    int framesSinceSwitch;              // Frames desde a ultima troca de limite do modo adaptativo
+    float latency;                      // Media movel do tempo entre ler os eventos do sistema e apresentar o frame que os usou
+    bool showStats;                     // Painel de metricas (F3)
+} FramePacer;
+
+// Cabecalho do arquivo de quicksave
+typedef struct {
+    char magic[4];      // "INFS"
+    uint32_t version;
+    uint32_t size;      // Bytes depois do cabecalho
+    uint32_t checksum;  // FNV-1a dos bytes depois do cabecalho
+} SaveHeader;
+
+// Parte fixa do quicksave. Mapa, moedas e inimigos iniciais nao sao gravados: vem do nivel carregado, o arquivo so guarda o que mudou
+typedef struct {
+    uint32_t levelHash;                 // Hash do mapa, o save so vale para o mesmo nivel
+    int32_t enemyCount;
+    int32_t coinCount;
+    int32_t liveEnemyCount;             // SavedEnemy gravados depois desta estrutura
+    int32_t projectileCount;            // Projectile ativos gravados depois dos inimigos
+    int32_t brokenCount;                // Blocos quebrados, (y << 16) | x, gravados depois dos projeteis
+    Player player;
+    Camera2D camera;
+    float frameTimer;
+    float frameTimerEnemies;
+    uint32_t currentFrame;
+    uint32_t currentEnemyFrame;
+    LevelCheckpoint checkpoint;
+    uint64_t deadEnemies[ENTITY_WORDS]; // Bit i: inimigo i morto
+    uint64_t takenCoins[ENTITY_WORDS];  // Bit i: moeda i coletada
+} SaveState;
+
+// Inimigo vivo no quicksave: so o que muda durante a partida
+typedef struct {
+    int32_t index;
+    int32_t health;
+    Vector2 position;
+    Vector2 velocity;
+    FixedVec2 fxPosition;
+    FixedVec2 fxVelocity;
+} SavedEnemy;
+
+// Observa o arquivo do mapa para recarregar o nivel quando ele for salvo
+typedef struct {
+    const char *fileName;
+    int fd;             // inotify (Linux) observando a pasta do mapa, -1 consulta a data de modificacao
+    long modTime;       // Ultima data de modificacao vista
+    double nextPoll;    // Proxima consulta da data de modificacao
+} MapWatcher;
+
+// Entrada do pacote de assets: imagens ja em RGBA (prontas para enviar a GPU) ou arquivos brutos (WAV ja e PCM)
+typedef struct {
+    char name[PAK_NAME_SIZE];   // Nome do arquivo original
+    int32_t isImage;            // 1 para imagem decodificada, 0 para arquivo bruto
+    int32_t width;
+    int32_t height;
+    int32_t format;             // Formato de pixel do raylib
+    uint32_t offset;            // Posicao dos dados a partir do inicio do pacote
+    uint32_t size;              // Tamanho dos dados em bytes
+} PakEntry;
+
+typedef struct {
+    char magic[4];              // "INFP"
+    uint32_t version;
+    uint32_t entryCount;
+} PakHeader;
+
+typedef struct {
+    unsigned char *data;        // Pacote inteiro, lido de uma vez e mantido ate o fim (a musica toca direto dele)
+    int size;
+    const PakEntry *entries;
+    int entryCount;
+} AssetPak;
+
+// Widget de interface desenhado na sua propria textura, so e redesenhado quando a chave (hash das entradas) muda
+typedef struct {
+    RenderTexture2D target;
+    unsigned int key;   // Hash das entradas usadas no ultimo desenho
+    bool valid;         // Se a textura ja tem um desenho com a chave atual
+} UiCache;
+
+typedef struct {
+    Rectangle rect;     // Posicao e tamanho na tela
+    const char *text;
+    int textWidth;      // Largura do texto, medida uma vez so na criacao
+    UiCache cache;      // Desenho do botao, refeito quando o mouse entra ou sai
+} MenuButton;
+
+// Telas do jogo. Cada uma e um passo de atualizar e desenhar um frame, chamado pelo laco principal, nenhuma tem laco proprio
+typedef enum {
+    SCENE_MENU,
+    SCENE_PLAYING,
+    SCENE_LEADERBOARD,
+    SCENE_EXIT,
+    SCENE_GAME_OVER,    // Tela de derrota, espera ENTER
+    SCENE_NAME_ENTRY    // Chegou ao portao: digita o nome para o placar
+} Scene;
+
+typedef struct {
+    Texture2D menuTexture;
+    MenuButton start;
+    MenuButton leaderboard;
+    MenuButton exit;
+    UiCache hud;                // Coracoes e pontos do jogador
+    UiCache leaderboardScreen;  // Tela do placar inteira
+    JogadorLeader top5[5];      // Placar lido do arquivo ao entrar na tela
+    bool top5Loaded;            // Arquivo ja lido nesta visita a tela (com ou sem sucesso)
+    bool top5Error;             // Arquivo nao pode ser lido: a tela mostra o erro em vez do placar
+    char nameBuffer[MAX_NOME];  // Nome sendo digitado na tela SCENE_NAME_ENTRY
+    int nameLength;
+    int pendingPoints;          // Pontos da partida que espera o nome para entrar no placar
+} GameUi;
+
+// Efeitos sonoros curtos, gerados e carregados uma vez na inicializacao
+typedef enum {
+    SFX_SHOT,       // Jogador atirou
+    SFX_PICKUP,     // Moeda coletada
+    SFX_HIT,        // Projetil acertou inimigo
+    SFX_HURT,       // Jogador perdeu vida
+    SFX_DEATH,      // Fim de jogo
+    SFX_COUNT
+} SoundEffect;
+
+typedef struct {
+    Music music;
+    bool hasMusic;
+    Sound voices[SFX_COUNT][SFX_VOICES];    // Vozes pre-carregadas de cada efeito
+    int nextVoice[SFX_COUNT];               // Proxima voz a usar (rodizio, a mais antiga e reaproveitada)
+    unsigned char queue[SFX_QUEUE_SIZE];    // Fila circular de efeitos pedidos pelo jogo
+    atomic_uint queueHead;                  // Escrito apenas pelo jogo
+    atomic_uint queueTail;                  // Escrito apenas pela thread de audio
+    atomic_bool running;
+    pthread_t thread;
+} AudioSystem;
+
+// Emissores de particulas, cada um com seu proprio orcamento dentro do pool
+typedef enum {
+    EMITTER_HIT,        // Projetil acertou inimigo
+    EMITTER_DEATH,      // Inimigo morreu
+    EMITTER_PICKUP,     // Moeda coletada
+    EMITTER_WALL,       // Projetil bateu em um bloco
+    EMITTER_COUNT
+} ParticleEmitter;
+
+typedef struct {
+    Color color;
+    float life;         // Segundos de vida de cada particula
+    float speed;        // Velocidade maxima de saida
+    float size;
+    int burst;          // Particulas por evento
+    int budget;         // Maximo de particulas vivas do emissor
+} ParticleEmitterInfo;
+
+// Pool de particulas em estrutura de vetores (SoA): as vivas ficam sempre em [0, count), cada campo em um vetor alinhado
+// para o laco de atualizacao processar 4 particulas por instrucao
+typedef struct {
+    float x[MAX_PARTICLES] __attribute__((aligned(16)));
+    float y[MAX_PARTICLES] __attribute__((aligned(16)));
+    float vx[MAX_PARTICLES] __attribute__((aligned(16)));
+    float vy[MAX_PARTICLES] __attribute__((aligned(16)));
+    float life[MAX_PARTICLES] __attribute__((aligned(16)));   // Tempo restante, <= 0 e particula morta
+    unsigned char emitter[MAX_PARTICLES];
+    int count;
+    int emitterCount[EMITTER_COUNT];    // Particulas vivas de cada emissor
+    uint32_t rng;
+} ParticleSystem;
+
+// Gera um efeito curto em memoria (onda quadrada ou ruido com frequencia deslizando e volume caindo) e carrega uma copia por voz
+void LoadEffectVoices(Sound voices[SFX_VOICES], float startFreq, float endFreq, float duration, bool noise) {
+    unsigned int frameCount = (unsigned int)(duration * SFX_SAMPLE_RATE);
+    short *samples = malloc(frameCount * sizeof(short));
+    if (!samples) return;
+
+    float phase = 0.0f;
+    unsigned int seed = 12345;
+    for (unsigned int i = 0; i < frameCount; i++) {
+        float t = (float)i / frameCount;
+        float freq = startFreq + (endFreq - startFreq) * t;
+        float value;
+        if (noise) {
+            seed = seed * 1103515245u + 12345u;
+            value = ((seed >> 16) & 1) ? 1.0f : -1.0f;
+        } else {
+            phase += freq / SFX_SAMPLE_RATE;
+            value = (phase - floorf(phase) < 0.5f) ? 1.0f : -1.0f;
+        }
+        samples[i] = (short)(value * (1.0f - t) * 6000.0f);
+    }
+
+    Wave wave = { frameCount, SFX_SAMPLE_RATE, 16, 1, samples };
+    for (int v = 0; v < SFX_VOICES; v++) {
+        voices[v] = LoadSoundFromWave(wave); // LoadSoundFromWave copia as amostras
+    }
+    free(samples);
+}
+
+// Pede para tocar um efeito. Nao bloqueia nem aloca: so escreve na fila, e descarta o pedido se ela estiver cheia
+void PlayEffect(AudioSystem *audio, SoundEffect effect) {
+    if (!audio) return;
+
+    unsigned int head = atomic_load_explicit(&audio->queueHead, memory_order_relaxed);
+    unsigned int tail = atomic_load_explicit(&audio->queueTail, memory_order_acquire);
+    if (head - tail >= SFX_QUEUE_SIZE) return;
+
+    audio->queue[head % SFX_QUEUE_SIZE] = (unsigned char)effect;
+    atomic_store_explicit(&audio->queueHead, head + 1, memory_order_release);
+}
+
+// Thread de audio: alimenta o stream da musica e toca os efeitos da fila, sem depender do tempo de frame do jogo
+void *AudioThread(void *arg) {
+    AudioSystem *audio = arg;
+    struct timespec pause = {0, 5 * 1000000}; // 5 ms entre atualizacoes
+
+    while (atomic_load(&audio->running)) {
+        if (audio->hasMusic) {
+            UpdateMusicStream(audio->music);
+        }
+
+        unsigned int tail = atomic_load_explicit(&audio->queueTail, memory_order_relaxed);
+        unsigned int head = atomic_load_explicit(&audio->queueHead, memory_order_acquire);
+        while (tail != head) {
+            int effect = audio->queue[tail % SFX_QUEUE_SIZE];
+            PlaySound(audio->voices[effect][audio->nextVoice[effect]]);
+            audio->nextVoice[effect] = (audio->nextVoice[effect] + 1) % SFX_VOICES;
+            tail++;
+        }
+        atomic_store_explicit(&audio->queueTail, tail, memory_order_release);
+
+        nanosleep(&pause, NULL);
+    }
+
+    return NULL;
+}
+
+// Carrega musica e efeitos e inicia a thread de audio. A partir daqui so a thread chama funcoes de audio do raylib
+void InitAudioSystem(AudioSystem *audio, Music music) {
+    memset(audio, 0, sizeof(*audio));
+
+    audio->music = music;
+    audio->hasMusic = audio->music.frameCount > 0;
+    if (audio->hasMusic) {
+        PlayMusicStream(audio->music);
+    }
+
+    LoadEffectVoices(audio->voices[SFX_SHOT], 880.0f, 440.0f, 0.08f, false);
+    LoadEffectVoices(audio->voices[SFX_PICKUP], 988.0f, 1319.0f, 0.12f, false);
+    LoadEffectVoices(audio->voices[SFX_HIT], 0.0f, 0.0f, 0.15f, true);
+    LoadEffectVoices(audio->voices[SFX_HURT], 330.0f, 165.0f, 0.25f, false);
+    LoadEffectVoices(audio->voices[SFX_DEATH], 440.0f, 110.0f, 0.6f, false);
+
+    atomic_store(&audio->running, true);
+    if (pthread_create(&audio->thread, NULL, AudioThread, audio) != 0) {
+        printf("Erro ao criar a thread de audio\n");
+        atomic_store(&audio->running, false);
+    }
+}
+
+// Para a thread de audio e descarrega musica e efeitos
+void CloseAudioSystem(AudioSystem *audio) {
+    if (atomic_exchange(&audio->running, false)) {
+        pthread_join(audio->thread, NULL);
+    }
+
+    if (audio->hasMusic) {
+        StopMusicStream(audio->music);
+        UnloadMusicStream(audio->music);
+        audio->hasMusic = false;
+    }
+    for (int e = 0; e < SFX_COUNT; e++) {
+        for (int v = 0; v < SFX_VOICES; v++) {
+            UnloadSound(audio->voices[e][v]);
+        }
+    }
+}
+
+// Reserva o bloco da arena com um unico malloc, feito uma vez no inicio do programa
+bool InitArena(Arena *arena, size_t size) {
+    arena->base = malloc(size);
+    arena->size = arena->base ? size : 0;
+    arena->used = 0;
+    arena->highWater = 0;
+    arena->last = 0;
+    return arena->base != NULL;
+}
+
+void FreeArena(Arena *arena) {
+    free(arena->base);
+    *arena = (Arena){0};
+}
+
+// Libera todas as alocacoes de uma vez, em O(1). Ponteiros entregues antes deixam de valer
+void ArenaReset(Arena *arena) {
+    arena->used = 0;
+    arena->last = 0;
+}
+
+// Entrega size bytes zerados e alinhados a ARENA_ALIGN, ou NULL se a arena nao tiver espaco
+void *ArenaAlloc(Arena *arena, size_t size) {
+    size_t start = (arena->used + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+    if (start > arena->size || size > arena->size - start) {
+        printf("Arena cheia: %zu de %zu bytes em uso, pedido de %zu\n", arena->used, arena->size, size);
+        return NULL;
+    }
+
+    arena->last = start;
+    arena->used = start + size;
+    if (arena->used > arena->highWater) {
+        arena->highWater = arena->used;
+    }
+    memset(arena->base + start, 0, size);
+    return arena->base + start;
+}
+
+// Muda o tamanho de um bloco da arena. A ultima alocacao cresce ou encolhe no lugar; as outras sao copiadas e o bloco antigo so volta no ArenaReset
+void *ArenaResize(Arena *arena, void *block, size_t oldSize, size_t newSize) {
+    if (block && (unsigned char *)block == arena->base + arena->last && arena->last + oldSize == arena->used) {
+        if (newSize > arena->size - arena->last) {
+            printf("Arena cheia: %zu de %zu bytes em uso, pedido de %zu\n", arena->used, arena->size, newSize - oldSize);
+            return NULL;
+        }
+        if (newSize > oldSize) {
+            memset((unsigned char *)block + oldSize, 0, newSize - oldSize);
+        }
+        arena->used = arena->last + newSize;
+        if (arena->used > arena->highWater) {
+            arena->highWater = arena->used;
+        }
+        return block;
+    }
+
+    if (newSize <= oldSize) return block;
+    void *grown = ArenaAlloc(arena, newSize);
+    if (grown && oldSize > 0) {
+        memcpy(grown, block, oldSize);
+    }
+    return grown;
+}
+
+// Copia um bloco de size bytes para a arena. Retorna NULL se nao couber
+void *ArenaCopy(Arena *arena, const void *block, size_t size) {
+    void *copy = ArenaAlloc(arena, size);
+    if (copy && size > 0) {
+        memcpy(copy, block, size);
+    }
+    return copy;
+}
+
+// Copia uma string para dentro da arena
+char *ArenaCopyString(Arena *arena, const char *text) {
+    return ArenaCopy(arena, text, strlen(text) + 1);
+}
+
+// Uso atual e pico da arena, para acompanhar quanto cada nivel ocupa
+void PrintArenaUsage(const Arena *arena, const char *label) {
+    printf("%s: %.1f KB em uso, pico de %.1f KB (de %.0f KB)\n", label,
+           arena->used / 1024.0, arena->highWater / 1024.0, arena->size / 1024.0);
+}
+
+// Le o mapa a partir de um arquivo, retorna false se o arquivo nao abre ou o mapa e pequeno demais
+bool LoadMap(const char* filename, char map[MAX_HEIGHT][MAX_WIDTH], int* rows, int* cols) {
     FILE* file = fopen(filename, "r");  // Le o arquivo
     if (!file) {
         perror("Failed to open file");
-        return;
+        return false;
     }
 
     // Inicia contagem das linhas e colunas em 0
@@ -123,7 +710,7 @@ void LoadMap(const char* filename, char map[MAX_HEIGHT][MAX_WIDTH], int* rows, i
     *cols = 0;
 
     char line[MAX_WIDTH];  // buffer pra armazenar cada linha e coluna
-    while (fgets(line, sizeof(line), file)) { // Le linha por linha
+    while (*rows < MAX_HEIGHT && fgets(line, sizeof(line), file)) { // Le linha por linha
         int length = strlen(line);  // Recebe o comprimento da linha atual
         if (line[length - 1] == '\n') line[length - 1] = '\0';  // Remove o caractere de nova linha
 
@@ -139,9 +726,476 @@ void LoadMap(const char* filename, char map[MAX_HEIGHT][MAX_WIDTH], int* rows, i
     fclose(file);
 
     if (*rows <= 10 || *cols <= 200) {
-        printf("Mapa menor do que 200x10");
-        exit(1);
+        printf("Mapa menor do que 200x10\n");
+        return false;
+    }
+    return true;
+}
+
+// Camadas de bits de um caractere do mapa (bit 1 << camada), 0 se o caractere nao tem camada
+unsigned TileLayersOf(char tile) {
+    switch (tile) {
+        case 'B': return 1u << TILE_SOLID;
+        case 'D': return (1u << TILE_SOLID) | (1u << TILE_BREAKABLE);
+        case 'O': return 1u << TILE_HAZARD;
+        case 'G': return 1u << TILE_GATE;
+        case 'C': return 1u << TILE_COLLECTABLE;
+        case 'K': return 1u << TILE_CHECKPOINT;
+        default: return 0;
+    }
+}
+
+// Aloca as camadas com rows linhas na arena, todas num bloco so, mantendo o conteudo das linhas que ja existiam. Retorna false se nao couber
+bool ResizeTileFlags(TileFlags *tiles, Arena *arena, int rows) {
+    size_t layerSize = rows * sizeof(tiles->bits[0][0]);
+    uint64_t (*block)[TILE_WORDS] = ArenaAlloc(arena, TILE_LAYER_COUNT * layerSize);
+    if (!block) return false;
+
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) {
+        uint64_t (*bits)[TILE_WORDS] = block + layer * rows;
+        if (tiles->rows > 0) {
+            memcpy(bits, tiles->bits[layer], (tiles->rows < rows ? tiles->rows : rows) * sizeof(bits[0]));
+        }
+        tiles->bits[layer] = bits;
+    }
+    tiles->rows = rows;
+    return true;
+}
+
+// Gera as camadas de bits a partir dos caracteres do mapa, feito uma vez so apos carregar o mapa. As camadas ja tem que ter rows linhas
+void BuildTileFlags(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, TileFlags *tiles) {
+    memset(tiles->bits[0], 0, TILE_LAYER_COUNT * tiles->rows * sizeof(tiles->bits[0][0])); // Camadas seguidas no mesmo bloco
+
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            unsigned layers = TileLayersOf(map[y][x]);
+            for (int layer = 0; layers; layer++, layers >>= 1) {
+                if (layers & 1) tiles->bits[layer][y][x >> 6] |= 1ULL << (x & 63);
+            }
+        }
+    }
+}
+
+// Retorna se o tile (x, y) tem a propriedade da camada, tiles fora do mapa nunca tem
+bool TileHas(const TileFlags *tiles, TileLayer layer, int x, int y) {
+    if (x < 0 || y < 0 || x >= MAX_WIDTH || y >= tiles->rows) {
+        return false;
+    }
+    return (tiles->bits[layer][y][x >> 6] >> (x & 63)) & 1;
+}
+
+// Retorna se algum tile da linha y entre as colunas x0 e x1 (inclusive) tem a propriedade, testando 64 tiles por vez
+bool TileSpanAny(const TileFlags *tiles, TileLayer layer, int y, int x0, int x1) {
+    if (y < 0 || y >= tiles->rows) return false;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= MAX_WIDTH) x1 = MAX_WIDTH - 1;
+    if (x0 > x1) return false;
+
+    const uint64_t *row = tiles->bits[layer][y];
+    int firstWord = x0 >> 6;
+    int lastWord = x1 >> 6;
+    uint64_t firstMask = ~0ULL << (x0 & 63);        // Ignora bits antes de x0
+    uint64_t lastMask = ~0ULL >> (63 - (x1 & 63));  // Ignora bits depois de x1
+
+    if (firstWord == lastWord) {
+        return (row[firstWord] & firstMask & lastMask) != 0;
+    }
+    if (row[firstWord] & firstMask) return true;
+    for (int w = firstWord + 1; w < lastWord; w++) {
+        if (row[w]) return true;
+    }
+    return (row[lastWord] & lastMask) != 0;
+}
+
+// Refaz a tabela de coinRank a partir da camada de moedas, chamado quando ela muda
+bool BuildCoinRank(Level *level) {
+    if (level->rows > level->coinRankRows) {
+        int (*grown)[TILE_WORDS] = ArenaResize(level->arena, level->coinRank,
+            level->coinRankRows * sizeof(level->coinRank[0]), level->rows * sizeof(level->coinRank[0]));
+        if (!grown) return false;
+        level->coinRank = grown;
+        level->coinRankRows = level->rows;
+    }
+
+    int count = 0;
+    for (int y = 0; y < level->rows; y++) {
+        for (int w = 0; w < TILE_WORDS; w++) {
+            level->coinRank[y][w] = count;
+            count += __builtin_popcountll(level->tiles->bits[TILE_COLLECTABLE][y][w]);
+        }
+    }
+    return true;
+}
+
+// Indice da moeda no tile (x, y), ou -1 se o tile nao tem moeda. As moedas estao na ordem de leitura do mapa, entao o indice e a quantidade de bits antes do tile
+int CoinAt(const Level *level, int x, int y) {
+    if (y >= level->rows || !TileHas(level->tiles, TILE_COLLECTABLE, x, y)) return -1;
+    uint64_t before = level->tiles->bits[TILE_COLLECTABLE][y][x >> 6] & ((1ULL << (x & 63)) - 1);
+    int index = level->coinRank[y][x >> 6] + __builtin_popcountll(before);
+    return index < level->initial.coinCount ? index : -1; // Moedas alem de MAX_WIDTH nao existem
+}
+
+static const int flowStepX[4] = {-1, 1, 0, 0}; // Vizinhos na ordem em que a busca e os inimigos os testam
+static const int flowStepY[4] = {0, 0, -1, 1};
+
+// Liga o campo de fluxo as celulas do nivel e as zera, ao comecar a partida ou quando o mapa muda de tamanho. Depois disso trocar a geracao basta para invalidar
+void ResetFlowField(FlowField *flow, const Level *level) {
+    flow->cells = level->flowCells;
+    flow->rows = level->rows;
+    flow->cols = level->cols;
+    memset(flow->cells, 0, flow->rows * flow->cols * sizeof(uint32_t));
+    flow->generation = 0;
+    flow->originX = -1;
+    flow->originY = -1;
+}
+
+// Distancia em tiles de (x, y) ate o jogador, -1 se a ultima busca nao chegou nesse tile
+int FlowDistance(const FlowField *flow, int x, int y) {
+    if (flow->generation == 0 || x < 0 || y < 0 || x >= flow->cols || y >= flow->rows) return -1;
+    uint32_t cell = flow->cells[y * flow->cols + x];
+    return (cell >> 16) == flow->generation ? (int)(cell & 0xFFFF) : -1;
+}
+
+// Refaz o campo de fluxo se o tile do alvo mudou desde a ultima busca: busca em largura pelos tiles nao solidos, ate FLOW_MAX_DISTANCE. Retorna se refez.
+// A busca e refeita do zero em vez de corrigir o campo antigo: com o alvo um tile adiante, toda distancia muda em +-1, entao uma correcao
+// incremental reescreveria as mesmas celulas e ainda precisaria achar as que ficaram mais longe. A geracao evita limpar o campo
+bool UpdateFlowField(FlowField *flow, const TileFlags *tiles, Rectangle target, float blockSize) {
+    int rows = flow->rows;
+    int cols = flow->cols;
+    int originX = (int)floorf((target.x + target.width / 2) / blockSize);
+    int originY = (int)floorf((target.y + target.height / 2) / blockSize);
+    if (originX < 0) originX = 0;
+    if (originX >= cols) originX = cols - 1;
+    if (originY < 0) originY = 0;
+    if (originY >= rows) originY = rows - 1;
+    if (originX == flow->originX && originY == flow->originY) return false;
+    flow->originX = originX;
+    flow->originY = originY;
+
+    // Nova geracao: tudo que foi marcado antes passa a contar como nao alcancado. Na volta dos 16 bits o campo e limpo de verdade
+    flow->generation = (flow->generation + 1) & 0xFFFF;
+    if (flow->generation == 0) {
+        memset(flow->cells, 0, rows * cols * sizeof(uint32_t));
+        flow->generation = 1;
+    }
+    uint32_t stamp = flow->generation << 16;
+    if (TileHas(tiles, TILE_SOLID, originX, originY)) return true; // Alvo dentro de um bloco: ninguem tem caminho
+
+    int head = 0;
+    int tail = 0;
+    flow->cells[originY * cols + originX] = stamp;
+    flow->queue[tail++] = (uint32_t)originY << 16 | (uint32_t)originX;
+    while (head < tail) {
+        uint32_t item = flow->queue[head++];
+        int x = item & 0xFFFF;
+        int y = item >> 16;
+        int distance = flow->cells[y * cols + x] & 0xFFFF;
+        if (distance == FLOW_MAX_DISTANCE) continue;
+
+        for (int d = 0; d < 4; d++) {
+            int nx = x + flowStepX[d];
+            int ny = y + flowStepY[d];
+            if (nx < 0 || ny < 0 || nx >= cols || ny >= rows) continue;
+            uint32_t *cell = &flow->cells[ny * cols + nx];
+            if ((*cell >> 16) == flow->generation) continue; // Ja alcancado por um caminho menor ou igual
+            if (TileHas(tiles, TILE_SOLID, nx, ny)) continue;
+            *cell = stamp | (uint32_t)(distance + 1);
+            flow->queue[tail++] = (uint32_t)ny << 16 | (uint32_t)nx;
+        }
+    }
+    return true;
+}
+
+// Proximo passo de (x, y) em direcao ao alvo: o primeiro vizinho com distancia um a menos. Retorna false sem caminho ou ja no tile do alvo
+bool FlowStep(const FlowField *flow, int x, int y, int *stepX, int *stepY) {
+    int distance = FlowDistance(flow, x, y);
+    if (distance <= 0) return false;
+    for (int d = 0; d < 4; d++) {
+        if (FlowDistance(flow, x + flowStepX[d], y + flowStepY[d]) == distance - 1) {
+            *stepX = flowStepX[d];
+            *stepY = flowStepY[d];
+            return true;
+        }
+    }
+    return false;
+}
+
+// Une tiles vizinhos da mesma camada em retangulos maximos (greedy meshing): estende cada tile livre na horizontal e depois desce linha a linha enquanto a faixa inteira continuar preenchida.
+// Tiles que tambem estao na camada exclude (-1 para nenhuma) ficam de fora
+int MergeTileRects(const TileFlags *tiles, TileLayer layer, int exclude, int rows, int cols, float blockSize, TileRect *rects, int capacity) {
+    uint64_t pending[MAX_HEIGHT][TILE_WORDS]; // Tiles da camada que ainda nao pertencem a nenhum retangulo
+    memcpy(pending, tiles->bits[layer], rows * sizeof(pending[0]));
+    if (exclude >= 0) {
+        for (int y = 0; y < rows; y++) {
+            for (int w = 0; w < TILE_WORDS; w++) {
+                pending[y][w] &= ~tiles->bits[exclude][y][w];
+            }
+        }
+    }
+    int count = 0;
+
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            if (!((pending[y][x >> 6] >> (x & 63)) & 1)) continue;
+
+            // Estende para a direita
+            int width = 1;
+            while (x + width < cols && ((pending[y][(x + width) >> 6] >> ((x + width) & 63)) & 1)) {
+                width++;
+            }
+
+            // Estende para baixo enquanto a linha de baixo cobrir toda a largura
+            int height = 1;
+            while (y + height < rows) {
+                int full = 1;
+                for (int i = x; i < x + width && full; i++) {
+                    full = (pending[y + height][i >> 6] >> (i & 63)) & 1;
+                }
+                if (!full) break;
+                height++;
+            }
+
+            // Marca os tiles como usados
+            for (int j = y; j < y + height; j++) {
+                for (int i = x; i < x + width; i++) {
+                    pending[j][i >> 6] &= ~(1ULL << (i & 63));
+                }
+            }
+
+            if (count == capacity) {
+                printf("Limite de retangulos unidos atingido (%d)\n", capacity);
+                return count;
+            }
+            rects[count].rect = (Rectangle){x * blockSize, y * blockSize, width * blockSize, height * blockSize};
+            rects[count].tilesX = width;
+            rects[count].tilesY = height;
+            count++;
+        }
+    }
+
+    return count;
+}
+
+// Encontra os tiles de checkpoint ('K') do mapa para desenha-los
+int FindCheckpoints(const TileFlags *tiles, int rows, int cols, float blockSize, Vector2 checkpoints[MAX_CHECKPOINTS]) {
+    int count = 0;
+    for (int y = 0; y < rows; y++) {
+        if (!TileSpanAny(tiles, TILE_CHECKPOINT, y, 0, cols - 1)) continue;
+        for (int x = 0; x < cols && count < MAX_CHECKPOINTS; x++) {
+            if (TileHas(tiles, TILE_CHECKPOINT, x, y)) {
+                checkpoints[count++] = (Vector2){x * blockSize, y * blockSize};
+            }
+        }
+    }
+    return count;
+}
+
+// Quantidade de tiles de uma camada, limite de quantos retangulos unidos ela pode gerar
+int CountLayerTiles(const TileFlags *tiles, TileLayer layer, int rows) {
+    int count = 0;
+    for (int y = 0; y < rows; y++) {
+        for (int w = 0; w < TILE_WORDS; w++) {
+            count += __builtin_popcountll(tiles->bits[layer][y][w]);
+        }
+    }
+    return count;
+}
+
+// Quantidade de caracteres tile no mapa, na mesma area que InitializeEnemies e InitializeCoins percorrem
+int CountMapTiles(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, char tile) {
+    int count = 0;
+    for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+            count += map[y][x] == tile;
+        }
+    }
+    return count;
+}
+
+// Refaz os retangulos unidos de uma camada. Cada retangulo cobre ao menos um tile, entao o vetor so cresce (na arena) quando a camada ganha tiles
+int RebuildLayerRects(Level *level, TileLayer layer, int exclude, TileRect **rects, int *capacity) {
+    int needed = CountLayerTiles(level->tiles, layer, level->rows);
+    if (needed > MAX_MERGED_RECTS) needed = MAX_MERGED_RECTS;
+    if (needed > *capacity) {
+        TileRect *grown = ArenaResize(level->arena, *rects, *capacity * sizeof(TileRect), needed * sizeof(TileRect));
+        if (grown) {
+            *rects = grown;
+            *capacity = needed;
+        }
+    }
+    return MergeTileRects(level->tiles, layer, exclude, level->rows, level->cols, BLOCK_SIZE, *rects, *capacity);
+}
+
+// FNV-1a, usado para validar o quicksave e identificar o nivel
+uint32_t SaveChecksum(const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+uint32_t LevelHash(const Level *level) {
+    return SaveChecksum(level->map, level->rows * sizeof(level->map[0]));
+}
+
+// Move o tile (x, y) das camadas de oldTile para as de newTile. Retorna as camadas afetadas (bit 1 << camada)
+unsigned SetTileLayers(TileFlags *tiles, int x, int y, char oldTile, char newTile) {
+    unsigned oldLayers = TileLayersOf(oldTile);
+    unsigned newLayers = TileLayersOf(newTile);
+    uint64_t bit = 1ULL << (x & 63);
+
+    for (int layer = 0; layer < TILE_LAYER_COUNT; layer++) {
+        if (oldLayers & (1u << layer)) {
+            tiles->bits[layer][y][x >> 6] &= ~bit;
+        }
+        if (newLayers & (1u << layer)) {
+            tiles->bits[layer][y][x >> 6] |= bit;
+        }
+    }
+    return oldLayers | newLayers;
+}
+
+// Muda um tile do nivel, atualizando o caractere e as camadas de bits. Retorna as camadas afetadas
+unsigned SetLevelTile(Level *level, int x, int y, char tile) {
+    unsigned changed = SetTileLayers(level->tiles, x, y, level->map[y][x], tile);
+    level->map[y][x] = tile;
+    return changed;
+}
+
+// Poe o bloco quebravel (x, y) no fim dos retangulos solidos. Retorna false sem espaco ou sem o indice por tile
+bool AddBreakableRect(Level *level, int x, int y) {
+    if (level->solidRectCount == level->solidRectCapacity || y >= level->breakableRectRows || x >= level->breakableRectCols) return false;
+    int i = level->solidRectCount++;
+    level->solidRects[i] = (TileRect){ {x * BLOCK_SIZE, y * BLOCK_SIZE, BLOCK_SIZE, BLOCK_SIZE}, 1, 1 };
+    level->breakableRect[y * level->breakableRectCols + x] = (int16_t)i;
+    return true;
+}
+
+// Tira o retangulo do bloco quebravel (x, y), trocando-o com o ultimo. Retorna false se o indice nao aponta para esse tile
+bool RemoveBreakableRect(Level *level, int x, int y) {
+    if (y >= level->breakableRectRows || x >= level->breakableRectCols) return false;
+    int i = level->breakableRect[y * level->breakableRectCols + x];
+    if (i < level->staticSolidRectCount || i >= level->solidRectCount ||
+            level->solidRects[i].rect.x != x * BLOCK_SIZE || level->solidRects[i].rect.y != y * BLOCK_SIZE) {
+        return false;
     }
+
+    TileRect moved = level->solidRects[--level->solidRectCount];
+    level->solidRects[i] = moved;
+    level->breakableRect[(int)(moved.rect.y / BLOCK_SIZE) * level->breakableRectCols + (int)(moved.rect.x / BLOCK_SIZE)] = (int16_t)i;
+    return true;
+}
+
+// Refaz os retangulos solidos: blocos fixos unidos primeiro e depois um retangulo 1x1 por bloco quebravel, que entra e sai sem mexer nos outros
+void RebuildSolidRects(Level *level) {
+    level->solidRectCount = RebuildLayerRects(level, TILE_SOLID, TILE_BREAKABLE, &level->solidRects, &level->solidRectCapacity);
+    level->staticSolidRectCount = level->solidRectCount;
+
+    if (CountLayerTiles(level->tiles, TILE_BREAKABLE, level->rows) == 0) return;
+    // O indice e refeito inteiro logo abaixo, entao basta trocar as dimensoes; so cresce se o mapa recarregado tem mais posicoes
+    int cells = level->rows * level->cols;
+    if (cells > level->breakableRectCapacity) {
+        int16_t *grown = ArenaResize(level->arena, level->breakableRect,
+            level->breakableRectCapacity * sizeof(int16_t), cells * sizeof(int16_t));
+        if (!grown) return;
+        level->breakableRect = grown;
+        level->breakableRectCapacity = cells;
+    }
+    level->breakableRectRows = level->rows;
+    level->breakableRectCols = level->cols;
+
+    for (int y = 0; y < level->rows; y++) {
+        for (int w = 0; w < TILE_WORDS; w++) {
+            uint64_t word = level->tiles->bits[TILE_BREAKABLE][y][w];
+            while (word) {
+                int x = w * 64 + __builtin_ctzll(word);
+                word &= word - 1;
+                if (!AddBreakableRect(level, x, y)) {
+                    printf("Limite de retangulos unidos atingido (%d)\n", level->solidRectCapacity);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// Refaz so os dados derivados das camadas que mudaram (retangulos unidos de colisao/desenho e lista de checkpoints)
+void RebuildLevelLayers(Level *level, unsigned layers) {
+    if (layers & ((1u << TILE_SOLID) | (1u << TILE_BREAKABLE))) {
+        RebuildSolidRects(level);
+    }
+    if (layers & (1u << TILE_HAZARD)) {
+        level->hazardRectCount = RebuildLayerRects(level, TILE_HAZARD, -1, &level->hazardRects, &level->hazardRectCapacity);
+    }
+    if (layers & (1u << TILE_GATE)) {
+        level->gateRectCount = RebuildLayerRects(level, TILE_GATE, -1, &level->gateRects, &level->gateRectCapacity);
+    }
+    if (layers & (1u << TILE_CHECKPOINT)) {
+        level->checkpointCount = FindCheckpoints(level->tiles, level->rows, level->cols, BLOCK_SIZE, level->checkpoints);
+    }
+    if (layers & (1u << TILE_COLLECTABLE)) {
+        BuildCoinRank(level);
+    }
+}
+
+// Aplica as trocas pedidas com EditLevelTile desde o ultimo commit. Blocos quebraveis entram e saem da colisao em O(1);
+// qualquer outra camada afetada e refeita uma vez so no fim. Retorna as camadas que mudaram
+unsigned CommitLevelEdits(Level *level) {
+    const unsigned breakableLayers = (1u << TILE_SOLID) | (1u << TILE_BREAKABLE);
+    unsigned changed = 0;
+    unsigned rebuild = 0;
+
+    for (int i = 0; i < level->editCount; i++) {
+        TileEdit edit = level->edits[i];
+        char oldTile = level->map[edit.y][edit.x];
+        if (oldTile == edit.tile) continue; // Pedido repetido no mesmo frame
+        bool wasBreakable = TileLayersOf(oldTile) & (1u << TILE_BREAKABLE);
+        bool isBreakable = TileLayersOf(edit.tile) & (1u << TILE_BREAKABLE);
+
+        // Bloco quebrado vai para o registro, de onde volta no reinicio do nivel
+        if (wasBreakable && !isBreakable) {
+            if (level->brokenCount == level->brokenCapacity) continue; // Registro cheio: o bloco aguenta
+            level->brokenTiles[level->brokenCount++] = (uint32_t)edit.y << 16 | (uint32_t)edit.x;
+        }
+
+        changed |= SetLevelTile(level, edit.x, edit.y, edit.tile);
+        rebuild |= TileLayersOf(oldTile) & ~(wasBreakable ? breakableLayers : 0);
+        rebuild |= TileLayersOf(edit.tile) & ~(isBreakable ? breakableLayers : 0);
+        if (wasBreakable && !RemoveBreakableRect(level, edit.x, edit.y)) rebuild |= 1u << TILE_SOLID;
+        if (isBreakable && !AddBreakableRect(level, edit.x, edit.y)) rebuild |= 1u << TILE_SOLID;
+    }
+
+    level->editCount = 0;
+    RebuildLevelLayers(level, rebuild);
+    return changed;
+}
+
+// Pede a troca do tile de terreno (x, y) durante a partida. Fica na lista de pendentes ate o proximo CommitLevelEdits, entao uma rajada
+// de mudancas custa so os tiles trocados. Entidades ('M', 'F', 'C', 'P') mudam pelo HotReloadLevel, que tambem corrige inimigos e moedas
+void EditLevelTile(Level *level, int x, int y, char tile) {
+    if (x < 0 || y < 0 || x >= level->cols || y >= level->rows) return;
+    if (level->editCount == TILE_EDIT_QUEUE_SIZE) {
+        CommitLevelEdits(level);
+    }
+    level->edits[level->editCount++] = (TileEdit){ (int16_t)x, (int16_t)y, tile };
+}
+
+// Remonta os blocos quebrados depois dos keep primeiros do registro (reinicio do nivel ou volta ao checkpoint). Retorna se algum voltou
+bool RestoreBrokenTiles(Level *level, int keep) {
+    CommitLevelEdits(level);
+    if (keep < 0) keep = 0;
+    if (keep >= level->brokenCount) return false;
+
+    int count = level->brokenCount;
+    level->brokenCount = keep;
+    for (int i = count - 1; i >= keep; i--) {
+        uint32_t cell = level->brokenTiles[i];
+        EditLevelTile(level, cell & 0xFFFF, cell >> 16, 'D');
+    }
+    CommitLevelEdits(level);
+    return true;
 }
 
 // Aplica calculo da gravidade
@@ -154,7 +1208,7 @@ bool FindPlayerSpawnPoint(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, P
     for (int y = 0; y < rows; y++) {
         for (int x = 0; x < cols; x++) {
             if (map[y][x] == 'P') { // letra P no mapa encontrada
-                player->spawnPoint = (Vector2){x * BLOCK_SIZE, y * BLOCK_SIZE};
+                player->spawnPoint = (Vector2){x * BLOCK_SIZE, (y + 1) * BLOCK_SIZE - player->rect.height}; // Pes do jogador na base do tile P, sem comecar dentro do chao
                 player->position = player->spawnPoint;
                 player->rect.x = player->position.x;
                 player->rect.y = player->position.y;
@@ -167,8 +1221,8 @@ bool FindPlayerSpawnPoint(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, P
     return false; // Nenhuma letra P foi encontrada, nao existe spawnpoint
 }
 
-void UpdateEnemyAnimationState(float *frameTimer, float frameSpeed, unsigned *currentFrame, Rectangle *frameRec, int frameWidth) {
-    *frameTimer += GetFrameTime(); // Pega tempo desde o ultimo frame
+void UpdateEnemyAnimationState(float *frameTimer, float frameSpeed, unsigned *currentFrame, Rectangle *frameRec, int frameWidth, float dt) {
+    *frameTimer += dt; // Tempo desde o ultimo frame
     if (*frameTimer >= frameSpeed) { // Troca sprite caso tempo decorrido for maior ou igual ao tempo desde o ultimo frame
         *frameTimer = 0.0f; // Reinicia timer p contagem
 
@@ -192,13 +1246,19 @@ void RenderBackground(Texture2D background, int rows, int cols) {
     }
 }
 
-// Renderiza moedas
-void RenderCoins(Coin coins[MAX_WIDTH], int coinCount) {
-    for (int i = 0; i < coinCount; i++) {
-        if (coins[i].active) {
-            DrawCircle((int)(coins[i].rect.x + coins[i].rect.width / 2.5),
-                       (int)(coins[i].rect.y + coins[i].rect.height / 2.5),
-                       coins[i].rect.width / 2.5, YELLOW);
+// Renderiza as moedas ativas, percorrendo so as colunas visiveis da camada de moedas
+void RenderCoins(const Level *level, const uint64_t activeCoins[ENTITY_WORDS], float blockSize, Rectangle view) {
+    int x0 = (int)floorf(view.x / blockSize);
+    int x1 = (int)floorf((view.x + view.width) / blockSize);
+    for (int y = 0; y < level->rows; y++) {
+        if (!TileSpanAny(level->tiles, TILE_COLLECTABLE, y, x0, x1)) continue;
+        for (int x = x0 < 0 ? 0 : x0; x <= x1 && x < MAX_WIDTH; x++) {
+            int i = CoinAt(level, x, y);
+            if (i < 0 || !((activeCoins[i >> 6] >> (i & 63)) & 1)) continue;
+            const Coin *coin = &level->initial.coins[i];
+            DrawCircle((int)(coin->rect.x + coin->rect.width / 2.5),
+                       (int)(coin->rect.y + coin->rect.height / 2.5),
+                       coin->rect.width / 2.5, YELLOW);
         }
     }
 }
@@ -212,72 +1272,282 @@ void RenderProjectiles(Projectile projectiles[MAX_PROJECTILES]) {
     }
 }
 
-// Renderiza inimigos
-void RenderEnemies(Enemy enemies[MAX_ENEMIES], int enemyCount, float blockSize, Texture2D enemyTexture,Rectangle *enemyFrameRec, float *frameTimer, unsigned *currentFrame) {
+// Retorna a area do mundo visivel pela camera
+Rectangle GetCameraView(Camera2D camera) {
+    return (Rectangle) {
+        camera.target.x - camera.offset.x / camera.zoom,
+        camera.target.y - camera.offset.y / camera.zoom,
+        SCREEN_WIDTH / camera.zoom,
+        SCREEN_HEIGHT / camera.zoom
+    };
+}
+
+// Renderiza inimigos. O relogio de animacao ja foi avancado uma vez no frame, aqui cada inimigo so soma sua fase ao quadro atual.
+// Todos usam a mesma textura, entao as chamadas seguidas de DrawTexturePro caem no mesmo lote e viram um unico draw call.
+void RenderEnemies(Enemy enemies[MAX_ENEMIES], int enemyCount, float blockSize, Texture2D enemyTexture, Rectangle enemyFrameRec, unsigned currentFrame, Rectangle view) {
+    Rectangle frames[2] = { enemyFrameRec, enemyFrameRec }; // Sprites possiveis, calculados uma vez so
+    frames[0].x = 0;
+    frames[1].x = enemyFrameRec.width;
+
     for (int i = 0; i < enemyCount; i++) {
         if (enemies[i].active) {
-            UpdateEnemyAnimationState(frameTimer, 0.5f, currentFrame, enemyFrameRec, 16); // Atualiza sprite
+            Rectangle destRect = {enemies[i].position.x, enemies[i].position.y, enemyFrameRec.width, enemyFrameRec.height}; // Cria retangulo p colissao
 
-            Rectangle destRect = {enemies[i].position.x, enemies[i].position.y, enemyFrameRec->width, enemyFrameRec->height}; // Cria retangulo p colissao
+            // Inimigos fora da camera nao sao desenhados
+            if (!CheckCollisionRecs(destRect, view)) continue;
 
             // Desenha inimigo com textura e retangulo criado acima
             DrawTexturePro(
                 enemyTexture,
-                *enemyFrameRec,
+                frames[(currentFrame + enemies[i].animPhase) & 1],
                 destRect,
                 (Vector2){0, 0},
                 0.0f,
-                WHITE
+                enemies[i].kind == ENEMY_FLYER ? SKYBLUE : WHITE // Voadores usam o mesmo sprite, so com outra cor
             );
         }
     }
 }
 
+typedef float ParticleVec __attribute__((vector_size(16))); // 4 floats, vira SSE/NEON conforme a maquina
+
+// Orcamentos somam MAX_PARTICLES: nenhum emissor tira espaco dos outros
+const ParticleEmitterInfo particleEmitters[EMITTER_COUNT] = {
+    [EMITTER_HIT]    = { ORANGE, 0.35f, 160.0f, 3.0f, 12, 2048 },
+    [EMITTER_DEATH]  = { RED,    0.80f, 220.0f, 4.0f, 48, 3072 },
+    [EMITTER_PICKUP] = { GOLD,   0.50f, 120.0f, 3.0f, 16, 1536 },
+    [EMITTER_WALL]   = { GRAY,   0.25f, 100.0f, 2.0f, 6,  1536 },
+};
+
+void ClearParticles(ParticleSystem *particles) {
+    particles->count = 0;
+    memset(particles->emitterCount, 0, sizeof(particles->emitterCount));
+    if (particles->rng == 0) particles->rng = 2463534242u;
+}
+
+// Numero aleatorio entre -1 e 1 (xorshift)
+float ParticleRandom(ParticleSystem *particles) {
+    uint32_t x = particles->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    particles->rng = x;
+    return (float)(x >> 8) / (float)(1 << 23) - 1.0f;
+}
+
+// Solta uma rajada do emissor em (x, y). Sem espaco no orcamento do emissor ou no pool, solta menos particulas (sem alocar nada)
+void EmitParticles(ParticleSystem *particles, ParticleEmitter emitter, float x, float y) {
+    if (!particles) return; // Simulacao sem janela
+
+    const ParticleEmitterInfo *info = &particleEmitters[emitter];
+    int amount = info->burst;
+    if (amount > info->budget - particles->emitterCount[emitter]) amount = info->budget - particles->emitterCount[emitter];
+    if (amount > MAX_PARTICLES - particles->count) amount = MAX_PARTICLES - particles->count;
+
+    for (int i = 0; i < amount; i++) {
+        int p = particles->count++;
+        particles->x[p] = x;
+        particles->y[p] = y;
+        particles->vx[p] = ParticleRandom(particles) * info->speed;
+        particles->vy[p] = ParticleRandom(particles) * info->speed - info->speed * 0.5f;
+        particles->life[p] = info->life * (0.75f + 0.25f * ParticleRandom(particles));
+        particles->emitter[p] = emitter;
+    }
+    particles->emitterCount[emitter] += amount;
+}
+
+// Integra todas as particulas 4 por vez com vetores do compilador, depois tira as mortas trocando com a ultima viva
+void UpdateParticles(ParticleSystem *particles, float dt, float gravity) {
+    // Completa o ultimo grupo de 4 com particulas mortas, o laco vetorial nao precisa de resto escalar
+    int padded = (particles->count + 3) & ~3;
+    for (int i = particles->count; i < padded; i++) {
+        particles->life[i] = 0.0f;
+    }
+
+    ParticleVec vdt = { dt, dt, dt, dt };
+    ParticleVec vgravity = vdt * gravity;
+    for (int i = 0; i < padded; i += 4) {
+        ParticleVec *x = (ParticleVec *)&particles->x[i];
+        ParticleVec *y = (ParticleVec *)&particles->y[i];
+        ParticleVec *vy = (ParticleVec *)&particles->vy[i];
+        ParticleVec *life = (ParticleVec *)&particles->life[i];
+        *x += *(ParticleVec *)&particles->vx[i] * vdt;
+        *vy += vgravity;
+        *y += *vy * vdt;
+        *life -= vdt;
+    }
+
+    for (int i = 0; i < particles->count; ) {
+        if (particles->life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        int last = --particles->count;
+        particles->emitterCount[particles->emitter[i]]--;
+        particles->x[i] = particles->x[last];
+        particles->y[i] = particles->y[last];
+        particles->vx[i] = particles->vx[last];
+        particles->vy[i] = particles->vy[last];
+        particles->life[i] = particles->life[last];
+        particles->emitter[i] = particles->emitter[last];
+    }
+}
+
+// Desenha as particulas visiveis. Sao todas retangulos sem textura e o pool cabe num lote do raylib, entao viram um draw call
+// (dois se o lote ja estava quase cheio com o resto do frame e esvazia no meio)
+void RenderParticles(const ParticleSystem *particles, Rectangle view) {
+    for (int i = 0; i < particles->count; i++) {
+        float x = particles->x[i];
+        float y = particles->y[i];
+        if (x < view.x || x > view.x + view.width || y < view.y || y > view.y + view.height) continue;
+
+        const ParticleEmitterInfo *info = &particleEmitters[particles->emitter[i]];
+        Color color = info->color;
+        color.a = (unsigned char)(255.0f * fminf(particles->life[i] / info->life, 1.0f)); // Some aos poucos
+        DrawRectangleV((Vector2){x, y}, (Vector2){info->size, info->size}, color);
+    }
+}
+
+// Desenha cada retangulo unido com uma unica chamada, repetindo a textura uma vez por tile (textura com wrap em modo repeat)
+void RenderTileRects(const TileRect *rects, int count, Texture2D texture, Color tint) {
+    for (int i = 0; i < count; i++) {
+        Rectangle source = {0, 0, texture.width * rects[i].tilesX, texture.height * rects[i].tilesY};
+        DrawTexturePro(texture, source, rects[i].rect, (Vector2){0, 0}, 0.0f, tint);
+    }
+}
+
 // Renderiza mapa
-void RenderMap(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, float blockSize, Texture2D blockTexture, Texture2D obstacleTexture, Texture2D gateTexture) {
-    for (int y = 0; y < rows; y++) {
-        for (int x = 0; x < cols; x++) {
-            if (map[y][x] == 'B') { // Caso for bloco
-                Rectangle destRect = {x * blockSize, y * blockSize, blockSize, blockSize};
-                DrawTexturePro(blockTexture, (Rectangle){0, 0, blockTexture.width, blockTexture.height}, destRect, (Vector2){0, 0}, 0.0f, WHITE);
-            } else if (map[y][x] == 'O') { // Caso for obstaculo
-                Rectangle destRect = {x * blockSize, y * blockSize, blockSize, blockSize};
-                DrawTexturePro(obstacleTexture, (Rectangle){0, 0, obstacleTexture.width, obstacleTexture.height}, destRect, (Vector2){0, 0}, 0.0f, WHITE);
-            } else if (map[y][x] == 'G') { // Caso for potal (gate)
-                Rectangle destRect = {x * blockSize, y * blockSize - 16, blockSize * 2, blockSize * 2};
+void RenderMap(Level *level, const LevelCheckpoint *checkpoint, float blockSize, Texture2D blockTexture, Texture2D obstacleTexture, Texture2D gateTexture) {
+    RenderTileRects(level->solidRects, level->staticSolidRectCount, blockTexture, WHITE); // Blocos
+    RenderTileRects(level->solidRects + level->staticSolidRectCount, level->solidRectCount - level->staticSolidRectCount,
+                    blockTexture, ORANGE);                                                  // Blocos quebraveis
+    RenderTileRects(level->hazardRects, level->hazardRectCount, obstacleTexture, WHITE);  // Obstaculos
+
+    // Checkpoints: bandeira verde no que esta ativo, cinza nos outros
+    for (int i = 0; i < level->checkpointCount; i++) {
+        Vector2 position = level->checkpoints[i];
+        bool reached = checkpoint->active && checkpoint->spawnPoint.x == position.x;
+        DrawRectangle(position.x + 2, position.y, 2, blockSize, DARKGRAY);
+        DrawRectangle(position.x + 4, position.y, blockSize - 6, blockSize / 2, reached ? GREEN : GRAY);
+    }
+
+    // Portoes (gate) ocupam 2x2 tiles acima da celula, entao sao desenhados um por tile
+    for (int i = 0; i < level->gateRectCount; i++) {
+        for (int y = 0; y < level->gateRects[i].tilesY; y++) {
+            for (int x = 0; x < level->gateRects[i].tilesX; x++) {
+                Rectangle destRect = {level->gateRects[i].rect.x + x * blockSize, level->gateRects[i].rect.y + y * blockSize - 16, blockSize * 2, blockSize * 2};
                 DrawTexturePro(gateTexture, (Rectangle) {0, 0, gateTexture.width, gateTexture.height}, destRect, (Vector2){0, 0}, 0.0f, WHITE);
             }
         }
     }
 }
 
-void RenderHUD(int health, Texture2D heartTexture, int points) {
-    // Desenha corações (pontos devida do jogador)
-    int heartX = 85;
-    int heartY = 37;
-    float heartWidth = 30.0f;
-    float heartHeight = 30.0f;
+// Mistura um valor no hash FNV-1a usado como chave dos widgets
+unsigned int UiHash(unsigned int hash, const void *data, int size) {
+    const unsigned char *bytes = data;
+    if (hash == 0) hash = 2166136261u;
+    for (int i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Retorna se o widget precisa ser redesenhado para a chave
+bool UiCacheNeedsRedraw(UiCache *cache, unsigned int key) {
+    return !cache->valid || cache->key != key;
+}
+
+// Comeca a desenhar o widget na sua textura, recriando a textura se o tamanho mudou. Deve ser chamado fora do BeginMode2D
+void UiCacheBegin(UiCache *cache, int width, int height, unsigned int key) {
+    if (cache->target.id == 0 || cache->target.texture.width != width || cache->target.texture.height != height) {
+        if (cache->target.id != 0) {
+            UnloadRenderTexture(cache->target);
+        }
+        cache->target = LoadRenderTexture(width, height);
+    }
+
+    cache->key = key;
+    cache->valid = true;
+    BeginTextureMode(cache->target);
+    ClearBackground(BLANK);
+}
+
+void UiCacheEnd(void) {
+    EndTextureMode();
+}
+
+// Desenha o widget guardado (texturas de render ficam de cabeca para baixo, por isso a altura negativa)
+void UiCacheDraw(UiCache *cache, float x, float y) {
+    Rectangle source = {0, 0, cache->target.texture.width, -cache->target.texture.height};
+    DrawTextureRec(cache->target.texture, source, (Vector2){x, y}, WHITE);
+}
 
-    for (int i = 0; i < health; i++) {
-        Rectangle destRect = { heartX + i * (heartWidth + 5), heartY, heartWidth, heartHeight };
-        DrawTexturePro(heartTexture, (Rectangle) {0, 0, heartTexture.width, heartTexture.height}, destRect, (Vector2){0, 0}, 0.0f, WHITE);
+void UnloadUiCache(UiCache *cache) {
+    if (cache->target.id != 0) {
+        UnloadRenderTexture(cache->target);
     }
+    cache->target.id = 0;
+    cache->valid = false;
+}
+
+// Desenha corações e pontos do jogador, redesenhando a textura do HUD so quando a vida ou os pontos mudam.
+// A textura tem tamanho fixo (vida maxima e o maior texto de pontos possivel), entao redesenhar nunca a recria
+void RenderHUD(int health, Texture2D heartTexture, int points, UiCache *cache) {
+    unsigned int key = UiHash(UiHash(0, &health, sizeof(health)), &points, sizeof(points));
+
+    if (UiCacheNeedsRedraw(cache, key)) {
+        // Desenha corações (pontos devida do jogador)
+        int heartX = 85;
+        int heartY = 37;
+        float heartWidth = 30.0f;
+        float heartHeight = 30.0f;
+
+        // Desenha texto "Vida"
+        int textX = 10;
+        int textY = 40;
+        int textHeight = 20;
+        int textWidth = MeasureText("Vida:", textHeight);
+
+        // Desenha pontos do jogador
+        const char *pointsText = TextFormat("Pontos: %d", points);
+        int pointsX = 10;
+        int pointsY = 70;
+        int pointsHeight = 20;
+        int pointsWidth = MeasureText(pointsText, pointsHeight);
+
+        // Maior texto de pontos: sinal e 10 casas, todas com o digito mais largo da fonte
+        char widestPoints[] = "Pontos: -0000000000";
+        char widestDigit = '0';
+        for (char c = '1'; c <= '9'; c++) {
+            if (MeasureText((char[]){ c, '\0' }, pointsHeight) > MeasureText((char[]){ widestDigit, '\0' }, pointsHeight)) {
+                widestDigit = c;
+            }
+        }
+        memset(widestPoints + 9, widestDigit, 10);
+
+        // Tamanho da textura: o suficiente para a vida maxima e o maior texto de pontos
+        int width = heartX + PLAYER_MAX_HEALTH * (heartWidth + 5);
+        int maxPointsWidth = MeasureText(widestPoints, pointsHeight);
+        if (pointsX + maxPointsWidth + 5 > width) width = pointsX + maxPointsWidth + 5;
+        int height = pointsY + pointsHeight + 5;
+
+        UiCacheBegin(cache, width, height, key);
+
+        for (int i = 0; i < health && i < PLAYER_MAX_HEALTH; i++) {
+            Rectangle destRect = { heartX + i * (heartWidth + 5), heartY, heartWidth, heartHeight };
+            DrawTexturePro(heartTexture, (Rectangle) {0, 0, heartTexture.width, heartTexture.height}, destRect, (Vector2){0, 0}, 0.0f, WHITE);
+        }
 
-    // Desenha texto "Vida"
-    int textX = 10;
-    int textY = 40;
-    int textHeight = 20;
-    int textWidth = MeasureText("Vida:", textHeight);
-    DrawRectangle(textX - 5, textY - 5, textWidth + 10, textHeight + 10, BLACK);
-    DrawText("Vida:", textX, textY, textHeight, WHITE);
+        DrawRectangle(textX - 5, textY - 5, textWidth + 10, textHeight + 10, BLACK);
+        DrawText("Vida:", textX, textY, textHeight, WHITE);
 
-    // Desenha pontos do jogador
-    int pointsX = 10;
-    int pointsY = 70;
-    int pointsHeight = 20;
-    int pointsWidth = MeasureText(TextFormat("Pontos: %d", points), pointsHeight);
-    DrawRectangle(pointsX - 5, pointsY - 5, pointsWidth + 10, pointsHeight + 10, BLACK);
-    DrawText(TextFormat("Pontos: %d", points), pointsX, pointsY, pointsHeight, WHITE);
+        DrawRectangle(pointsX - 5, pointsY - 5, pointsWidth + 10, pointsHeight + 10, BLACK);
+        DrawText(pointsText, pointsX, pointsY, pointsHeight, WHITE);
+
+        UiCacheEnd();
+    }
+
+    UiCacheDraw(cache, 0, 0);
 }
 
 // Inicializacao do jogador
@@ -292,8 +1562,13 @@ Player InitializePlayer() {
         3,
         0,
         " \n",
+        {0, 0},
         0,
-        0
+        0.0f,
+        {0, 0},
+        {0, 0},
+        0.0f,
+        0.0f
     };
     return player;
 }
@@ -311,13 +1586,163 @@ Camera2D InitializeCamera(Player *player) {
     return camera;
 }
 
+// Arquivos convertidos pelo --bake, na ordem em que entram no pacote
+const char *bakedAssets[] = {
+    "background.png", "tile1.png", "spike.png", "gate.png", "enemies.png",
+    "heart.png", "inf_man.png", "player-sheet.png", "musica_jogo.wav"
+};
+
+// Converte os PNGs para RGBA ja decodificado e junta tudo (com o WAV) em um unico arquivo de pacote
+int BakeAssets(const char *pakFile) {
+    int count = sizeof(bakedAssets) / sizeof(bakedAssets[0]);
+    PakEntry entries[sizeof(bakedAssets) / sizeof(bakedAssets[0])] = {0};
+    unsigned char *blobs[sizeof(bakedAssets) / sizeof(bakedAssets[0])] = {0};
+    Image images[sizeof(bakedAssets) / sizeof(bakedAssets[0])] = {0};
+    int entryCount = 0;
+    uint32_t offset = sizeof(PakHeader) + count * sizeof(PakEntry);
+
+    for (int i = 0; i < count; i++) {
+        if (!FileExists(bakedAssets[i])) {
+            printf("Asset %s nao encontrado, ficara de fora do pacote\n", bakedAssets[i]);
+            continue;
+        }
+
+        PakEntry *entry = &entries[entryCount];
+        strncpy(entry->name, bakedAssets[i], PAK_NAME_SIZE - 1);
+
+        if (strstr(bakedAssets[i], ".png")) {
+            images[entryCount] = LoadImage(bakedAssets[i]);
+            ImageFormat(&images[entryCount], PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+            entry->isImage = 1;
+            entry->width = images[entryCount].width;
+            entry->height = images[entryCount].height;
+            entry->format = images[entryCount].format;
+            entry->size = GetPixelDataSize(entry->width, entry->height, entry->format);
+            blobs[entryCount] = images[entryCount].data;
+        } else {
+            int size = 0;
+            blobs[entryCount] = LoadFileData(bakedAssets[i], &size);
+            entry->size = size;
+        }
+
+        if (!blobs[entryCount]) {
+            printf("Asset %s nao pode ser lido, ficara de fora do pacote\n", bakedAssets[i]);
+            *entry = (PakEntry){0};
+            continue;
+        }
+
+        offset = (offset + 15) & ~15u; // Dados alinhados em 16 bytes
+        entry->offset = offset;
+        offset += entry->size;
+        entryCount++;
+    }
+
+    FILE *arq = fopen(pakFile, "wb");
+    if (!arq) {
+        printf("Erro ao criar %s!\n", pakFile);
+        return 1;
+    }
+
+    PakHeader header = { {'I', 'N', 'F', 'P'}, PAK_VERSION, entryCount };
+    fwrite(&header, sizeof(header), 1, arq);
+    fwrite(entries, sizeof(PakEntry), entryCount, arq);
+    for (int i = 0; i < entryCount; i++) {
+        fseek(arq, entries[i].offset, SEEK_SET);
+        fwrite(blobs[i], 1, entries[i].size, arq);
+        if (entries[i].isImage) {
+            UnloadImage(images[i]);
+        } else {
+            UnloadFileData(blobs[i]);
+        }
+        printf("%s: %u bytes\n", entries[i].name, entries[i].size);
+    }
+    fclose(arq);
+
+    printf("Pacote %s criado com %d assets\n", pakFile, entryCount);
+    return 0;
+}
+
+// Confere se a entrada cabe no pacote e, se for imagem, se o formato e o que o --bake grava e os pixels cabem nos dados
+bool PakEntryValid(const PakEntry *entry, int pakSize) {
+    if (memchr(entry->name, '\0', PAK_NAME_SIZE) == NULL) return false;
+    if ((uint64_t)entry->offset + entry->size > (uint64_t)pakSize) return false;
+    if (!entry->isImage) return true;
+    if (entry->format != PIXELFORMAT_UNCOMPRESSED_R8G8B8A8) return false;
+    if (entry->width <= 0 || entry->height <= 0 || entry->width > PAK_MAX_IMAGE_SIZE || entry->height > PAK_MAX_IMAGE_SIZE) return false;
+    return (uint32_t)GetPixelDataSize(entry->width, entry->height, entry->format) <= entry->size;
+}
+
+// Le o pacote de assets com uma unica leitura. Sem pacote (ou pacote invalido) os assets sao carregados dos arquivos originais
+AssetPak LoadAssetPak(const char *pakFile) {
+    AssetPak pak = {0};
+    if (!FileExists(pakFile)) return pak;
+
+    pak.data = LoadFileData(pakFile, &pak.size);
+    if (!pak.data) return pak;
+
+    const PakHeader *header = (const PakHeader *)pak.data;
+    if (pak.size < (int)sizeof(PakHeader) || memcmp(header->magic, "INFP", 4) != 0 || header->version != PAK_VERSION ||
+            sizeof(PakHeader) + (uint64_t)header->entryCount * sizeof(PakEntry) > (uint64_t)pak.size) {
+        printf("Pacote %s invalido, usando os arquivos originais\n", pakFile);
+        UnloadFileData(pak.data);
+        return (AssetPak){0};
+    }
+
+    pak.entries = (const PakEntry *)(pak.data + sizeof(PakHeader));
+    pak.entryCount = header->entryCount;
+    for (int i = 0; i < pak.entryCount; i++) {
+        if (!PakEntryValid(&pak.entries[i], pak.size)) {
+            printf("Entrada %d do pacote %s invalida, usando os arquivos originais\n", i, pakFile);
+            UnloadFileData(pak.data);
+            return (AssetPak){0};
+        }
+    }
+    return pak;
+}
+
+// Procura um asset no pacote pelo nome do arquivo original
+const PakEntry *FindPakEntry(const AssetPak *pak, const char *name) {
+    for (int i = 0; i < pak->entryCount; i++) {
+        if (strncmp(pak->entries[i].name, name, PAK_NAME_SIZE) == 0) { // Entradas ja conferidas em LoadAssetPak
+            return &pak->entries[i];
+        }
+    }
+    return NULL;
+}
+
+// Carrega textura do pacote (sem abrir arquivo nem descomprimir PNG) ou, se nao estiver nele, do arquivo
+Texture2D LoadGameTexture(const AssetPak *pak, const char *fileName) {
+    const PakEntry *entry = FindPakEntry(pak, fileName);
+    if (entry && entry->isImage) {
+        Image image = { pak->data + entry->offset, entry->width, entry->height, 1, entry->format };
+        return LoadTextureFromImage(image); // Copia os pixels para a GPU, o pacote continua dono da memoria
+    }
+    return LoadTexture(fileName);
+}
+
+// Carrega a musica do pacote (tocada direto da memoria) ou do arquivo
+Music LoadGameMusic(const AssetPak *pak, const char *fileName) {
+    const PakEntry *entry = FindPakEntry(pak, fileName);
+    if (entry && !entry->isImage) {
+        return LoadMusicStreamFromMemory(".wav", pak->data + entry->offset, entry->size);
+    }
+    return LoadMusicStream(fileName);
+}
+
+void UnloadAssetPak(AssetPak *pak) {
+    if (pak->data) {
+        UnloadFileData(pak->data);
+    }
+    *pak = (AssetPak){0};
+}
+
 // Inicializacao das texturas do jogador
-void InitializePlayerTextureAndAnimation(Texture2D *infmanTex, Rectangle *frameRec, int *frameWidth, Texture2D *enemyTex, Rectangle *enemyFrameRec, int *enemyFrameWidth) {
-    *infmanTex = LoadTexture("player-sheet.png");
+void InitializePlayerTextureAndAnimation(const AssetPak *pak, Texture2D *infmanTex, Rectangle *frameRec, int *frameWidth, Texture2D *enemyTex, Rectangle *enemyFrameRec, int *enemyFrameWidth) {
+    *infmanTex = LoadGameTexture(pak, "player-sheet.png");
     *frameWidth = infmanTex->width / 12;
     *frameRec = (Rectangle){0.0f, 0.0f, (float)(*frameWidth), (float)infmanTex->height};
 
-    *enemyTex = LoadTexture("enemies.png");
+    *enemyTex = LoadGameTexture(pak, "enemies.png");
     *enemyFrameWidth = enemyTex->width / 2;
     *enemyFrameRec = (Rectangle){0.0f, 0.0f, (float)(*enemyFrameWidth), (float)enemyTex->height};
 }
@@ -329,21 +1754,39 @@ void InitializeProjectiles(Projectile projectiles[MAX_PROJECTILES]) {
     }
 }
 
-// Encontra instancias da letra "M" no arquivo e criar inimigos pra cada uma delas
+// Tipo de inimigo de um caractere do mapa, -1 se o caractere nao cria inimigo
+int EnemyKindOf(char tile) {
+    switch (tile) {
+        case 'M': return ENEMY_PATROL;
+        case 'F': return ENEMY_FLYER;
+        default: return -1;
+    }
+}
+
+// Cria o inimigo do tile 'M' ou 'F' em (x, y). Voadores comecam parados, a direcao vem do campo de fluxo
+Enemy CreateEnemy(int x, int y, EnemyKind kind, float blockSize, float enemySpeedX, float enemySpeedY, float offset) {
+    Enemy enemy = {0};
+    enemy.kind = kind;
+    enemy.position = (Vector2){x * blockSize, y * blockSize};
+    enemy.velocity = kind == ENEMY_PATROL ? (Vector2){enemySpeedX, enemySpeedY} : (Vector2){0, 0}; // Velocidade do inimigo
+    enemy.rect = (Rectangle){enemy.position.x, enemy.position.y, blockSize, blockSize}; // Retangulo p colisao
+    enemy.minPosition = enemy.position; // Posicao minimia é o spawnpoint
+    enemy.maxPosition = (Vector2){enemy.position.x + (kind == ENEMY_PATROL ? offset : 0), enemy.position.y}; // Posicao maxima
+    enemy.health = 1; // Vida que começa
+    enemy.active = true; // Inimigo é ativado
+    enemy.animPhase = (x + y) & 1; // Alterna a fase entre vizinhos para nao andarem sincronizados
+    return enemy;
+}
+
+// Encontra instancias das letras "M" e "F" no arquivo e criar inimigos pra cada uma delas
 int InitializeEnemies(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, Enemy enemies[MAX_WIDTH], float blockSize, float enemySpeedX, float enemySpeedY, float offset) {
     int enemyCount = 0;
 
     for (int y = 0; y < rows; y++) {
         for (int x = 0; x < cols; x++) {
-            if (map[y][x] == 'M') {
-                enemies[enemyCount].position = (Vector2){x * blockSize, y * blockSize};
-                enemies[enemyCount].velocity = (Vector2){enemySpeedX, enemySpeedY}; // Velocidade do inimigo
-                enemies[enemyCount].rect = (Rectangle){enemies[enemyCount].position.x, enemies[enemyCount].position.y, blockSize, blockSize}; // Retangulo p colisao
-                enemies[enemyCount].minPosition = enemies[enemyCount].position; // Posicao minimia é o spawnpoint
-                enemies[enemyCount].maxPosition = (Vector2){enemies[enemyCount].position.x + offset, enemies[enemyCount].position.y}; // Posicao maxima
-                enemies[enemyCount].health = 1; // Vida que começa
-                enemies[enemyCount].active = true; // Inimigo é ativado
-                enemyCount++;
+            int kind = EnemyKindOf(map[y][x]);
+            if (kind >= 0 && enemyCount < MAX_WIDTH) {
+                enemies[enemyCount++] = CreateEnemy(x, y, kind, blockSize, enemySpeedX, enemySpeedY, offset);
             }
         }
     }
@@ -351,18 +1794,23 @@ int InitializeEnemies(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, Enemy
     return enemyCount;
 }
 
+// Cria a moeda do tile 'C' em (x, y)
+Coin CreateCoin(int x, int y, float blockSize) {
+    Coin coin;
+    coin.position = (Vector2){x * blockSize, y * blockSize};
+    coin.rect = (Rectangle){coin.position.x, coin.position.y, blockSize, blockSize}; // Retangulo p colisao
+    coin.points = 10; // A moeda dá 10
+    return coin;
+}
+
 // Inicializa as moedas no mapa
 int InitializeCoins(char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, Coin coins[MAX_WIDTH], float blockSize) {
     int coinCount = 0;
 
     for (int y = 0; y < rows; y++) {
         for (int x = 0; x < cols; x++) {
-            if (map[y][x] == 'C') { // Moeda no mapa
-                coins[coinCount].position = (Vector2){x * blockSize, y * blockSize};
-                coins[coinCount].rect = (Rectangle){coins[coinCount].position.x, coins[coinCount].position.y, blockSize, blockSize}; // Retangulo p colisao
-                coins[coinCount].active = true; // Marca a moeda como ativa
-                coins[coinCount].points = 10; // A moeda dá 10
-                coinCount++;
+            if (map[y][x] == 'C' && coinCount < MAX_WIDTH) { // Moeda no mapa
+                coins[coinCount++] = CreateCoin(x, y, blockSize);
             }
         }
     }
@@ -379,30 +1827,88 @@ void HandleRespawn(Player *player, float screenHeight) {
     }
 }
 
-// Aplica movimento para o jogador conforme a tecla pressionada
-void CheckMovementKey(Player *player, float moveSpeed, float jumpForce) {
+// Le os comandos do jogador no teclado
+// Passa os apertos de tecla do frame para a fila, na ordem em que aconteceram, com o momento da leitura
+void CollectInputEvents(InputQueue *queue, double now) {
+    int key;
+    while ((key = GetKeyPressed()) != 0) {
+        InputAction action;
+        switch (key) {
+            case KEY_SPACE: action = INPUT_JUMP; break;
+            case KEY_Z: action = INPUT_SHOOT; break;
+            case KEY_X: action = INPUT_SHOOT_VERTICAL; break;
+            default: continue;
+        }
+
+        if (queue->count == INPUT_QUEUE_SIZE) { // Fila cheia: descarta o mais antigo
+            queue->head = (queue->head + 1) % INPUT_QUEUE_SIZE;
+            queue->count--;
+        }
+        queue->events[(queue->head + queue->count) % INPUT_QUEUE_SIZE] = (InputEvent){ now, action };
+        queue->count++;
+    }
+}
+
+// Monta os comandos de um passo: setas seguradas lidas na hora, apertos tirados da fila em ordem, no maximo um de cada acao por passo
+PlayerInput ReadPlayerInput(InputQueue *queue, double now) {
+    PlayerInput input = {
+        .left = IsKeyDown(KEY_LEFT),
+        .right = IsKeyDown(KEY_RIGHT)
+    };
+
+    // Percorre a fila inteira compactando no lugar: um aperto repetido fica para o proximo passo sem segurar as outras acoes atras dele
+    int kept = 0;
+    for (int i = 0; i < queue->count; i++) {
+        InputEvent event = queue->events[(queue->head + i) % INPUT_QUEUE_SIZE];
+        if (now - event.time > INPUT_EVENT_MAX_AGE) continue; // Velho demais: descartado
+        bool *target = event.action == INPUT_JUMP ? &input.jump :
+                       event.action == INPUT_SHOOT ? &input.shoot : &input.shootVertical;
+        if (*target) {
+            queue->events[(queue->head + kept++) % INPUT_QUEUE_SIZE] = event; // Mesma acao ja usada neste passo
+        } else {
+            *target = true;
+        }
+    }
+    queue->count = kept;
+    return input;
+}
+
+// Aplica movimento para o jogador conforme a tecla pressionada. O pulo usa as janelas de buffer e coyote time, com as duas em 0 so pula no chao
+void CheckMovementKey(Player *player, PlayerInput input, float moveSpeed, float jumpForce, float jumpBufferTime, float coyoteTime, float dt) {
     player->velocity.x = 0;
 
-    if (IsKeyDown(KEY_RIGHT)) {
+    if (input.right) {
         player->velocity.x = moveSpeed;
         player->facingRight = true;
     }
-    if (IsKeyDown(KEY_LEFT)) {
+    if (input.left) {
         player->velocity.x = -moveSpeed;
         player->facingRight = false;
     }
-    if (IsKeyPressed(KEY_SPACE) && player->isGrounded) {
+    if (player->isGrounded) {
+        player->coyoteTimer = coyoteTime;
+    }
+
+    bool wantsJump = input.jump || player->jumpBuffer > 0;
+    bool canJump = player->isGrounded || player->coyoteTimer > 0;
+    if (wantsJump && canJump) {
         player->velocity.y = jumpForce;
         player->isGrounded = false;
+        player->jumpBuffer = 0;
+        player->coyoteTimer = 0;
+    } else if (input.jump) {
+        player->jumpBuffer = jumpBufferTime; // Ainda no ar: guarda o pulo
     }
+
+    player->jumpBuffer -= dt;
+    player->coyoteTimer -= dt;
 }
 
 // Cria projetil com coordenadas baseadas na posição atual do jogador e aplica estado do jogador estar atirando durante 0.5 segundos
-void CreateProjectile(Player *player, Projectile projectiles[MAX_PROJECTILES], float projectileWidth, float projectileHeight, float projectileSpeed, float dt) {
-    static float shootTimer = 0.0f;
+void CreateProjectile(Player *player, PlayerInput input, Projectile projectiles[MAX_PROJECTILES], float projectileWidth, float projectileHeight, float projectileSpeed, float dt, AudioSystem *audio) {
     float animationDuration = 0.5;
 
-    if (IsKeyPressed(KEY_Z)) {
+    if (input.shoot) {
         player->isShooting = true;
 
         for (int i = 0; i < MAX_PROJECTILES; i++) {
@@ -419,13 +1925,14 @@ void CreateProjectile(Player *player, Projectile projectiles[MAX_PROJECTILES], f
                 };
                 projectiles[i].color = YELLOW;
                 projectiles[i].active = true;
+                PlayEffect(audio, SFX_SHOT);
                 break;
             }
         }
     }
 
     // Variacao de disparo (vertical)
-    if (IsKeyPressed(KEY_X)) {
+    if (input.shootVertical) {
         player->isShooting = true;
 
         for (int i = 0; i < MAX_PROJECTILES; i++) {
@@ -443,6 +1950,7 @@ void CreateProjectile(Player *player, Projectile projectiles[MAX_PROJECTILES], f
                 }
                 projectiles[i].active = true;
                 projectiles[i].color = BLUE;
+                PlayEffect(audio, SFX_SHOT);
                 break;
             }
         }
@@ -450,10 +1958,10 @@ void CreateProjectile(Player *player, Projectile projectiles[MAX_PROJECTILES], f
 
     // Duracao da animacao de atirar
     if (player->isShooting) {
-        shootTimer += dt;
-        if (shootTimer >= animationDuration) {
+        player->shootTimer += dt;
+        if (player->shootTimer >= animationDuration) {
             player->isShooting = false;
-            shootTimer = 0.0f;
+            player->shootTimer = 0.0f;
         }
     }
 }
@@ -465,20 +1973,110 @@ void MoveCamera(Camera2D *camera, Player *player) {
     };
 }
 
-// Move jogador com base na velocidade multiplicada pelo frame atual
-void MovePlayer(Player *player, float moveSpeed, float jumpForce, float dt) {
-    CheckMovementKey(player, moveSpeed, jumpForce);
+// Desloca o retangulo no eixo X ate o primeiro tile solido no caminho (tempo de impacto contra a grade), retorna se houve impacto
+bool SweepRectX(Rectangle *rect, float delta, const TileFlags *tiles, float blockSize) {
+    // Linhas ocupadas pelo retangulo, sem contar as que ele apenas encosta
+    int rowStart = (int)floorf(rect->y / blockSize);
+    int rowEnd = (int)ceilf((rect->y + rect->height) / blockSize) - 1;
+
+    if (delta > 0) {
+        // Colunas cuja borda esquerda fica entre a frente do retangulo e o destino
+        float front = rect->x + rect->width;
+        int first = (int)ceilf(front / blockSize);
+        int last = (int)ceilf((front + delta) / blockSize) - 1;
+        for (int x = first; x <= last; x++) {
+            for (int y = rowStart; y <= rowEnd; y++) {
+                if (TileHas(tiles, TILE_SOLID, x, y)) {
+                    rect->x = x * blockSize - rect->width; // Para encostado no tile
+                    return true;
+                }
+            }
+        }
+    } else if (delta < 0) {
+        // Colunas cuja borda direita fica entre a frente do retangulo e o destino
+        float front = rect->x;
+        int first = (int)floorf(front / blockSize) - 1;
+        int last = (int)floorf((front + delta) / blockSize);
+        for (int x = first; x >= last; x--) {
+            for (int y = rowStart; y <= rowEnd; y++) {
+                if (TileHas(tiles, TILE_SOLID, x, y)) {
+                    rect->x = (x + 1) * blockSize;
+                    return true;
+                }
+            }
+        }
+    }
+
+    rect->x += delta;
+    return false;
+}
+
+// Desloca o retangulo no eixo Y ate o primeiro tile solido no caminho, testando cada linha com as camadas de bits
+bool SweepRectY(Rectangle *rect, float delta, const TileFlags *tiles, float blockSize) {
+    // Colunas ocupadas pelo retangulo, sem contar as que ele apenas encosta
+    int colStart = (int)floorf(rect->x / blockSize);
+    int colEnd = (int)ceilf((rect->x + rect->width) / blockSize) - 1;
+
+    if (delta > 0) {
+        float front = rect->y + rect->height;
+        int first = (int)ceilf(front / blockSize);
+        int last = (int)ceilf((front + delta) / blockSize) - 1;
+        for (int y = first; y <= last; y++) {
+            if (TileSpanAny(tiles, TILE_SOLID, y, colStart, colEnd)) {
+                rect->y = y * blockSize - rect->height;
+                return true;
+            }
+        }
+    } else if (delta < 0) {
+        float front = rect->y;
+        int first = (int)floorf(front / blockSize) - 1;
+        int last = (int)floorf((front + delta) / blockSize);
+        for (int y = first; y >= last; y--) {
+            if (TileSpanAny(tiles, TILE_SOLID, y, colStart, colEnd)) {
+                rect->y = (y + 1) * blockSize;
+                return true;
+            }
+        }
+    }
+
+    rect->y += delta;
+    return false;
+}
+
+// Move jogador com base na velocidade, dividindo o frame em subpassos e varrendo cada deslocamento contra a grade de tiles para nao atravessar plataformas finas com frames longos
+void MovePlayer(Player *player, PlayerInput input, const GameConfig *config, const TileFlags *tiles, float dt) {
+    CheckMovementKey(player, input, config->playerSpeed, config->jumpForce, config->jumpBufferTime, config->coyoteTime, dt);
 
-    // Atualiza posicao de acordo com velocidade
-    player->position.x += player->velocity.x * dt;
-    player->position.y += player->velocity.y * dt;
-    player->rect.x = player->position.x;
-    player->rect.y = player->position.y;
+    // Subpassos suficientes para nenhum passar de maxSubstepTime, limitados pelo orcamento maxSubsteps
+    int substeps = (int)ceilf(dt / config->maxSubstepTime);
+    if (substeps < 1) substeps = 1;
+    if (substeps > config->maxSubsteps) substeps = config->maxSubsteps;
+    float step = dt / substeps;
+
+    for (int i = 0; i < substeps; i++) {
+        ApplyGravity(player, config->gravity, step);
+        player->isGrounded = false;
+
+        // Atualiza posicao de acordo com velocidade, um eixo por vez
+        if (SweepRectX(&player->rect, player->velocity.x * step, tiles, BLOCK_SIZE)) {
+            player->velocity.x = 0;
+        }
+        if (SweepRectY(&player->rect, player->velocity.y * step, tiles, BLOCK_SIZE)) {
+            if (player->velocity.y > 0) {
+                player->isGrounded = true; // Bateu no chao
+            }
+            player->velocity.y = 0;
+        }
+
+        player->position.x = player->rect.x;
+        player->position.y = player->rect.y;
+    }
 }
 
 // Move os inimigos com base na velocidade multiplicada pelo frame atual
 void MoveEnemies(Enemy* enemies, int enemyCount, float dt) {
     for (int i = 0; i < enemyCount; i++) {
+        if (enemies[i].kind != ENEMY_PATROL) continue;
         // Faz o inimigo ir e voltar
         if (enemies[i].position.x <= enemies[i].minPosition.x || enemies[i].position.x >= enemies[i].maxPosition.x) {
             enemies[i].velocity.x = -enemies[i].velocity.x; // Inverte direção
@@ -490,14 +2088,18 @@ void MoveEnemies(Enemy* enemies, int enemyCount, float dt) {
 }
 
 // Desativa projeteis quando batem em um bloco
-void CheckProjectileBlockCollision(Projectile *projectile, Rectangle block) {
+bool CheckProjectileBlockCollision(Projectile *projectile, Rectangle block, ParticleSystem *particles) {
     if (CheckCollisionRecs(projectile->rect, block)) {
         projectile->active = false;
+        EmitParticles(particles, EMITTER_WALL, projectile->rect.x + projectile->rect.width / 2, projectile->rect.y + projectile->rect.height / 2);
+        return true;
     }
+    return false;
 }
 
 // Move projeteis quanndo disparados
-void MoveProjectiles(Projectile projectiles[MAX_PROJECTILES], float dt, Player* player, int screenWidth, char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, float blockSize) {
+void MoveProjectiles(Projectile projectiles[MAX_PROJECTILES], float dt, Player* player, int screenWidth, Level *level, float blockSize, ParticleSystem *particles) {
+    const TileFlags *tiles = level->tiles;
     for (int i = 0; i < MAX_PROJECTILES; i++) {
         if (projectiles[i].active) {
             // Movimento do projetil
@@ -513,12 +2115,19 @@ void MoveProjectiles(Projectile projectiles[MAX_PROJECTILES], float dt, Player*
                 projectiles[i].active = false;
             }
 
-            // Verifica colisao com blocos
-            for (int y = 0; y < rows; y++) {
-                for (int x = 0; x < cols; x++) {
-                    if (map[y][x] == 'B') {  // Verifica bloco a bloco ate achar um
+            // Verifica colisao apenas com os blocos nas celulas cobertas pelo projetil
+            int x0 = (int)floorf(projectiles[i].rect.x / blockSize);
+            int x1 = (int)floorf((projectiles[i].rect.x + projectiles[i].rect.width) / blockSize);
+            int y0 = (int)floorf(projectiles[i].rect.y / blockSize);
+            int y1 = (int)floorf((projectiles[i].rect.y + projectiles[i].rect.height) / blockSize);
+            for (int y = y0; y <= y1 && projectiles[i].active; y++) {
+                if (!TileSpanAny(tiles, TILE_SOLID, y, x0, x1)) continue;
+                for (int x = x0; x <= x1; x++) {
+                    if (TileHas(tiles, TILE_SOLID, x, y)) {
                         Rectangle block = {x * blockSize, y * blockSize, blockSize, blockSize};
-                        CheckProjectileBlockCollision(&projectiles[i], block);
+                        if (CheckProjectileBlockCollision(&projectiles[i], block, particles) && TileHas(tiles, TILE_BREAKABLE, x, y)) {
+                            EditLevelTile(level, x, y, ' '); // Bloco quebravel: some no fim do frame
+                        }
                     }
                 }
             }
@@ -526,20 +2135,301 @@ void MoveProjectiles(Projectile projectiles[MAX_PROJECTILES], float dt, Player*
     }
 }
 
+// Converte entre float e ponto fixo. Multiplicar por 2^16 e exato, entao a conversao so trunca a fracao que nao cabe
+fixed_t FxFromFloat(float value) {
+    return (fixed_t)(value * (float)FX_ONE);
+}
+
+float FxToFloat(fixed_t value) {
+    return (float)value / (float)FX_ONE;
+}
+
+// Produto de dois valores 16.16 com intermediario de 64 bits
+fixed_t FxMul(fixed_t a, fixed_t b) {
+    return (fixed_t)(((int64_t)a * b) >> FX_SHIFT);
+}
+
+fixed_t FxClamp(fixed_t value, fixed_t limit) {
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+// Divisao inteira arredondada para baixo/cima, tambem para valores negativos (divisor sempre positivo)
+int FxFloorDiv(fixed_t a, fixed_t b) {
+    int q = a / b;
+    if (a % b != 0 && a < 0) q--;
+    return q;
+}
+
+int FxCeilDiv(fixed_t a, fixed_t b) {
+    int q = a / b;
+    if (a % b != 0 && a > 0) q++;
+    return q;
+}
+
+// O resto do jogo (respawn, checkpoint, tiros) escreve direto nos campos float. Se o float nao bate mais com o valor
+// em ponto fixo, ele foi alterado por fora e o valor em ponto fixo e refeito a partir dele
+void FxSync(fixed_t *fixed, float value) {
+    if (value != FxToFloat(*fixed)) {
+        *fixed = FxFromFloat(value);
+    }
+}
+
+// Passo de tempo do frame em ponto fixo, limitado para os deslocamentos caberem em 32 bits
+fixed_t FxFrameStep(float dt) {
+    fixed_t step = FxFromFloat(dt);
+    return step > FX_MAX_FRAME ? FX_MAX_FRAME : step;
+}
+
+// Verifica se ha tile solido na linha (vertical) ou coluna (horizontal) "line", entre os indices from e to do outro eixo
+bool FxSolidLine(const TileFlags *tiles, int line, int from, int to, bool vertical) {
+    if (vertical) {
+        return TileSpanAny(tiles, TILE_SOLID, line, from, to);
+    }
+    for (int y = from; y <= to; y++) {
+        if (TileHas(tiles, TILE_SOLID, line, y)) return true;
+    }
+    return false;
+}
+
+// Versao em ponto fixo de SweepRectX/SweepRectY: desloca pos (borda do retangulo no eixo do movimento) ate o primeiro tile solido.
+// cross e crossSize descrevem o retangulo no outro eixo
+bool SweepFixed(fixed_t *pos, fixed_t size, fixed_t cross, fixed_t crossSize, fixed_t delta, bool vertical, const TileFlags *tiles) {
+    const fixed_t block = BLOCK_SIZE << FX_SHIFT;
+    int crossStart = FxFloorDiv(cross, block);
+    int crossEnd = FxCeilDiv(cross + crossSize, block) - 1;
+
+    if (delta > 0) {
+        fixed_t front = *pos + size;
+        int first = FxCeilDiv(front, block);
+        int last = FxCeilDiv(front + delta, block) - 1;
+        for (int i = first; i <= last; i++) {
+            if (FxSolidLine(tiles, i, crossStart, crossEnd, vertical)) {
+                *pos = i * block - size;
+                return true;
+            }
+        }
+    } else if (delta < 0) {
+        int first = FxFloorDiv(*pos, block) - 1;
+        int last = FxFloorDiv(*pos + delta, block);
+        for (int i = first; i >= last; i--) {
+            if (FxSolidLine(tiles, i, crossStart, crossEnd, vertical)) {
+                *pos = (i + 1) * block;
+                return true;
+            }
+        }
+    }
+
+    *pos += delta;
+    return false;
+}
+
+// Mesmo movimento de MovePlayer, com posicao, velocidade, gravidade e subpassos em inteiros
+void MovePlayerFixed(Player *player, PlayerInput input, const GameConfig *config, const TileFlags *tiles, float dt) {
+    CheckMovementKey(player, input, config->playerSpeed, config->jumpForce, config->jumpBufferTime, config->coyoteTime, dt);
+
+    FxSync(&player->fxPosition.x, player->position.x);
+    FxSync(&player->fxPosition.y, player->position.y);
+    FxSync(&player->fxVelocity.x, player->velocity.x);
+    FxSync(&player->fxVelocity.y, player->velocity.y);
+
+    fixed_t frame = FxFrameStep(dt);
+    fixed_t maxStep = FxFromFloat(config->maxSubstepTime);
+    int substeps = maxStep > 0 ? FxCeilDiv(frame, maxStep) : 1;
+    if (substeps < 1) substeps = 1;
+    if (substeps > config->maxSubsteps) substeps = config->maxSubsteps;
+    fixed_t step = frame / substeps;
+
+    fixed_t gravity = FxFromFloat(config->gravity);
+    fixed_t width = FxFromFloat(player->rect.width);
+    fixed_t height = FxFromFloat(player->rect.height);
+    FixedVec2 *pos = &player->fxPosition;
+    FixedVec2 *vel = &player->fxVelocity;
+
+    for (int i = 0; i < substeps; i++) {
+        vel->y = FxClamp(vel->y + FxMul(gravity, step), FX_MAX_SPEED);
+        vel->x = FxClamp(vel->x, FX_MAX_SPEED);
+        player->isGrounded = false;
+
+        if (SweepFixed(&pos->x, width, pos->y, height, FxMul(vel->x, step), false, tiles)) {
+            vel->x = 0;
+        }
+        if (SweepFixed(&pos->y, height, pos->x, width, FxMul(vel->y, step), true, tiles)) {
+            if (vel->y > 0) {
+                player->isGrounded = true; // Bateu no chao
+            }
+            vel->y = 0;
+        }
+        pos->x = FxClamp(pos->x, FX_MAX_COORD);
+        pos->y = FxClamp(pos->y, FX_MAX_COORD);
+    }
+
+    player->position = (Vector2){ FxToFloat(pos->x), FxToFloat(pos->y) };
+    player->velocity = (Vector2){ FxToFloat(vel->x), FxToFloat(vel->y) };
+    player->rect.x = player->position.x;
+    player->rect.y = player->position.y;
+}
+
+// Mesmo vai e volta de MoveEnemies em inteiros. O laco so tem somas, comparacoes e multiplicacoes inteiras
+void MoveEnemiesFixed(Enemy* enemies, int enemyCount, float dt) {
+    fixed_t step = FxFrameStep(dt);
+
+    for (int i = 0; i < enemyCount; i++) {
+        if (enemies[i].kind != ENEMY_PATROL) continue;
+        FxSync(&enemies[i].fxPosition.x, enemies[i].position.x);
+        FxSync(&enemies[i].fxVelocity.x, enemies[i].velocity.x);
+
+        fixed_t minX = FxFromFloat(enemies[i].minPosition.x);
+        fixed_t maxX = FxFromFloat(enemies[i].maxPosition.x);
+        if (enemies[i].fxPosition.x <= minX || enemies[i].fxPosition.x >= maxX) {
+            enemies[i].fxVelocity.x = -enemies[i].fxVelocity.x; // Inverte direção
+        }
+        enemies[i].fxPosition.x = FxClamp(enemies[i].fxPosition.x + FxMul(enemies[i].fxVelocity.x, step), FX_MAX_COORD);
+
+        enemies[i].position.x = FxToFloat(enemies[i].fxPosition.x);
+        enemies[i].velocity.x = FxToFloat(enemies[i].fxVelocity.x);
+        enemies[i].rect.x = enemies[i].position.x;
+        enemies[i].rect.y = enemies[i].position.y;
+    }
+}
+
+// Voadores andam de tile em tile seguindo o campo de fluxo, que so e refeito quando algum voador ativo precisa dele.
+// A direcao so muda com o inimigo alinhado a um tile, entao o retangulo passa so por tiles livres e nunca corta o canto de um bloco.
+// O movimento e em ponto fixo nos dois modos de fisica para o alinhamento ser exato
+void MoveFlyers(Enemy *enemies, int enemyCount, FlowField *flow, const TileFlags *tiles, Rectangle target, float speed, float blockSize, float dt) {
+    const fixed_t block = FxFromFloat(blockSize);
+    const fixed_t speedFx = FxFromFloat(speed);
+    const fixed_t frameDistance = FxMul(speedFx, FxFrameStep(dt));
+    bool flowReady = false;
+
+    for (int i = 0; i < enemyCount; i++) {
+        Enemy *enemy = &enemies[i];
+        if (enemy->kind != ENEMY_FLYER || !enemy->active) continue;
+        if (!flowReady) {
+            UpdateFlowField(flow, tiles, target, blockSize);
+            flowReady = true;
+        }
+
+        FixedVec2 *pos = &enemy->fxPosition;
+        FixedVec2 *vel = &enemy->fxVelocity;
+        FxSync(&pos->x, enemy->position.x);
+        FxSync(&pos->y, enemy->position.y);
+        FxSync(&vel->x, enemy->velocity.x);
+        FxSync(&vel->y, enemy->velocity.y);
+
+        fixed_t remaining = frameDistance;
+        while (remaining > 0) {
+            bool aligned = pos->x % block == 0 && pos->y % block == 0;
+            if (aligned) {
+                int stepX, stepY;
+                if (!FlowStep(flow, pos->x / block, pos->y / block, &stepX, &stepY)) {
+                    *vel = (FixedVec2){0, 0}; // Sem caminho ou ja no tile do jogador
+                    break;
+                }
+                *vel = (FixedVec2){stepX * speedFx, stepY * speedFx};
+            } else if (vel->x == 0 && vel->y == 0) {
+                // Parado entre dois tiles (posicao mudada por fora): volta para o tile mais proximo
+                pos->x = FxFloorDiv(pos->x + block / 2, block) * block;
+                pos->y = FxFloorDiv(pos->y + block / 2, block) * block;
+                break;
+            }
+
+            // Anda ate a proxima linha da grade no eixo do movimento, onde pode trocar de direcao
+            fixed_t *axis = vel->x != 0 ? &pos->x : &pos->y;
+            bool forward = (vel->x != 0 ? vel->x : vel->y) > 0;
+            fixed_t next = forward ? (FxFloorDiv(*axis, block) + 1) * block : (FxCeilDiv(*axis, block) - 1) * block;
+            fixed_t distance = forward ? next - *axis : *axis - next;
+            if (remaining < distance) {
+                *axis += forward ? remaining : -remaining;
+                break;
+            }
+            *axis = next;
+            remaining -= distance;
+        }
+
+        enemy->position = (Vector2){ FxToFloat(pos->x), FxToFloat(pos->y) };
+        enemy->velocity = (Vector2){ FxToFloat(vel->x), FxToFloat(vel->y) };
+        enemy->rect.x = enemy->position.x;
+        enemy->rect.y = enemy->position.y;
+    }
+}
+
+// Mesmo movimento de MoveProjectiles em inteiros. Os tiles testados sao os que o projetil cobre de fato, entao qualquer bloco solido entre eles e colisao
+void MoveProjectilesFixed(Projectile projectiles[MAX_PROJECTILES], float dt, Player* player, int screenWidth, Level *level, ParticleSystem *particles) {
+    const TileFlags *tiles = level->tiles;
+    const fixed_t block = BLOCK_SIZE << FX_SHIFT;
+    fixed_t step = FxFrameStep(dt);
+    fixed_t range = screenWidth << FX_SHIFT;
+
+    FxSync(&player->fxPosition.x, player->position.x);
+    FxSync(&player->fxPosition.y, player->position.y);
+
+    for (int i = 0; i < MAX_PROJECTILES; i++) {
+        if (!projectiles[i].active) continue;
+
+        Projectile *projectile = &projectiles[i];
+        FxSync(&projectile->fxPosition.x, projectile->rect.x);
+        FxSync(&projectile->fxPosition.y, projectile->rect.y);
+        FxSync(&projectile->fxSpeed.x, projectile->speed.x);
+        FxSync(&projectile->fxSpeed.y, projectile->speed.y);
+
+        projectile->fxPosition.x = FxClamp(projectile->fxPosition.x + FxMul(projectile->fxSpeed.x, step), FX_MAX_COORD);
+        projectile->fxPosition.y = FxClamp(projectile->fxPosition.y + FxMul(projectile->fxSpeed.y, step), FX_MAX_COORD);
+        projectile->rect.x = FxToFloat(projectile->fxPosition.x);
+        projectile->rect.y = FxToFloat(projectile->fxPosition.y);
+
+        // Desativa se vai pra fora da tela
+        fixed_t dx = projectile->fxPosition.x - player->fxPosition.x;
+        fixed_t dy = projectile->fxPosition.y - player->fxPosition.y;
+        if (dx < -range || dx > range || dy < -range || dy > range) {
+            projectile->active = false;
+            continue;
+        }
+
+        fixed_t width = FxFromFloat(projectile->rect.width);
+        fixed_t height = FxFromFloat(projectile->rect.height);
+        int x0 = FxFloorDiv(projectile->fxPosition.x, block);
+        int x1 = FxCeilDiv(projectile->fxPosition.x + width, block) - 1;
+        int y0 = FxFloorDiv(projectile->fxPosition.y, block);
+        int y1 = FxCeilDiv(projectile->fxPosition.y + height, block) - 1;
+        for (int y = y0; y <= y1; y++) {
+            if (TileSpanAny(tiles, TILE_SOLID, y, x0, x1)) {
+                projectile->active = false;
+                EmitParticles(particles, EMITTER_WALL, projectile->rect.x + projectile->rect.width / 2, projectile->rect.y + projectile->rect.height / 2);
+                for (int x = x0; x <= x1; x++) {
+                    if (TileHas(tiles, TILE_BREAKABLE, x, y)) EditLevelTile(level, x, y, ' ');
+                }
+                break;
+            }
+        }
+    }
+}
+
 
-// Colisao entre jogador e moeda
-void CheckPlayerCoinCollision(Player* player, Coin* coins, int* coinCount) {
-    for (int i = 0; i < *coinCount; i++) {
-        if (coins[i].active && CheckCollisionRecs(player->rect, coins[i].rect)) {
-            player->points += coins[i].points; // Incrementa pontos do jogador
-            coins[i].active = false;
-            printf("Points: %d\n", player->points);
+// Colisao entre jogador e moeda: so os tiles embaixo do jogador sao consultados
+void CheckPlayerCoinCollision(Player* player, const Level *level, uint64_t activeCoins[ENTITY_WORDS], float blockSize, AudioSystem *audio, ParticleSystem *particles) {
+    int x0 = (int)floorf(player->rect.x / blockSize);
+    int x1 = (int)floorf((player->rect.x + player->rect.width) / blockSize);
+    int y0 = (int)floorf(player->rect.y / blockSize);
+    int y1 = (int)floorf((player->rect.y + player->rect.height) / blockSize);
+    for (int y = y0; y <= y1; y++) {
+        for (int x = x0; x <= x1; x++) {
+            int i = CoinAt(level, x, y);
+            if (i < 0 || !((activeCoins[i >> 6] >> (i & 63)) & 1)) continue;
+            const Coin *coin = &level->initial.coins[i];
+            if (CheckCollisionRecs(player->rect, coin->rect)) {
+                player->points += coin->points; // Incrementa pontos do jogador
+                activeCoins[i >> 6] &= ~(1ULL << (i & 63));
+                PlayEffect(audio, SFX_PICKUP);
+                EmitParticles(particles, EMITTER_PICKUP, coin->rect.x + coin->rect.width / 2, coin->rect.y + coin->rect.height / 2);
+            }
         }
     }
 }
 
 // Verifica colisão entre o projétil e inimigo
-void CheckProjectileEnemyCollision(Projectile* projectiles, int* enemyCount, Enemy* enemies, Player* player) {
+void CheckProjectileEnemyCollision(Projectile* projectiles, int* enemyCount, Enemy* enemies, Player* player, AudioSystem *audio, ParticleSystem *particles) {
     for (int i = 0; i < MAX_PROJECTILES; i++) {
         if (projectiles[i].active) {
             for (int j = 0; j < *enemyCount; j++) {
@@ -547,9 +2437,14 @@ void CheckProjectileEnemyCollision(Projectile* projectiles, int* enemyCount, Ene
                     // Colisão detectada reduz a vida do inimigo
                     enemies[j].health -= 1;  // Diminui a vida
                     player->points += 100;
+                    PlayEffect(audio, SFX_HIT);
+                    float centerX = enemies[j].rect.x + enemies[j].rect.width / 2;
+                    float centerY = enemies[j].rect.y + enemies[j].rect.height / 2;
+                    EmitParticles(particles, EMITTER_HIT, centerX, centerY);
                     if (enemies[j].health <= 0) {
                         enemies[j].health = 0;
                         enemies[j].active = false; // Desativa o inimigo se a vida chegar a 0
+                        EmitParticles(particles, EMITTER_DEATH, centerX, centerY);
                     }
                     projectiles[i].active = false;  // Desativa projetil após colisão
                     break;
@@ -582,26 +2477,53 @@ bool CheckCollisionWithBlock(Rectangle player, Rectangle block, Vector2* correct
     return false;
 }
 
-// Dado um texto para preencher e uma coordenada, desenha um retângulo
-Rectangle CreateMenuButton(const char *text, int yOffset) {
-    return (Rectangle) {
-        SCREEN_WIDTH / 2 - MeasureText(text, 50) / 2,
-                     SCREEN_HEIGHT / 2 + yOffset,
-                     MeasureText(text, 50),
-                     50
+// Dado um texto para preencher e uma coordenada, cria o retângulo do botão medindo o texto uma vez só
+MenuButton CreateMenuButton(const char *text, int yOffset) {
+    int width = MeasureText(text, 50);
+    MenuButton button = {
+        .rect = { SCREEN_WIDTH / 2 - width / 2, SCREEN_HEIGHT / 2 + yOffset, width, 50 },
+        .text = text,
+        .textWidth = MeasureText(text, 20)
     };
+    return button;
 }
 
-// Desenha botão com efeito de trocar de cor quando mouse passa por cima
-void DrawButton(Rectangle button, const char *text, Vector2 mouse, Color hoverColor, Color defaultColor) {
-    Color buttonColor = CheckCollisionPointRec(mouse, button) ? hoverColor : defaultColor;
-    DrawRectangleRec(button, buttonColor);
-    DrawText(text, button.x + button.width / 2 - MeasureText(text, 20) / 2, button.y + 15, 20, BLACK);
+// Desenha botão com efeito de trocar de cor quando mouse passa por cima, refazendo a textura do botão só quando o estado de hover muda
+void DrawButton(MenuButton *button, Vector2 mouse, Color hoverColor, Color defaultColor) {
+    bool hover = CheckCollisionPointRec(mouse, button->rect);
+
+    if (UiCacheNeedsRedraw(&button->cache, hover)) {
+        Color buttonColor = hover ? hoverColor : defaultColor;
+        UiCacheBegin(&button->cache, button->rect.width, button->rect.height, hover);
+        DrawRectangle(0, 0, button->rect.width, button->rect.height, buttonColor);
+        DrawText(button->text, button->rect.width / 2 - button->textWidth / 2, 15, 20, BLACK);
+        UiCacheEnd();
+    }
+
+    UiCacheDraw(&button->cache, button->rect.x, button->rect.y);
 }
 
 // Detecta se mouse clicou em cima do botão
-int HandleButtonClick(Rectangle button, Vector2 mouse) {
-    return CheckCollisionPointRec(mouse, button) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+int HandleButtonClick(MenuButton *button, Vector2 mouse) {
+    return CheckCollisionPointRec(mouse, button->rect) && IsMouseButtonPressed(MOUSE_LEFT_BUTTON);
+}
+
+// Carrega a textura do menu e cria os botões uma vez só
+void InitGameUi(GameUi *ui, const AssetPak *pak) {
+    memset(ui, 0, sizeof(*ui));
+    ui->menuTexture = LoadGameTexture(pak, "inf_man.png");
+    ui->start = CreateMenuButton("Iniciar", 0);
+    ui->leaderboard = CreateMenuButton("Placar de pontos", 100);
+    ui->exit = CreateMenuButton("Sair", 200);
+}
+
+void UnloadGameUi(GameUi *ui) {
+    UnloadTexture(ui->menuTexture);
+    UnloadUiCache(&ui->start.cache);
+    UnloadUiCache(&ui->leaderboard.cache);
+    UnloadUiCache(&ui->exit.cache);
+    UnloadUiCache(&ui->hud);
+    UnloadUiCache(&ui->leaderboardScreen);
 }
 
 // Caso haja colisão entre jogador e o bloco, e bloco seja M, usa a diferença entre as duas posições, a variavel correction, é usada para manter o jogador na sua posição.
@@ -626,62 +2548,214 @@ void HandleBlockCollision(Player *player, Rectangle block) {
     }
 }
 
-int Menu(void) {
-    Texture2D initializeTexture = LoadTexture("inf_man.png");
+// Versao em ponto fixo de HandleBlockCollision: sobreposicao e correcao calculadas em inteiros sobre a posicao fxPosition
+void HandleBlockCollisionFixed(Player *player, Rectangle block) {
+    FxSync(&player->fxPosition.x, player->position.x);
+    FxSync(&player->fxPosition.y, player->position.y);
 
-    // Inicialização dos botões
-    Rectangle start = CreateMenuButton("Iniciar", 0);
-    Rectangle leaderboard = CreateMenuButton("Placar de pontos", 100);
-    Rectangle exit = CreateMenuButton("Sair", 200);
-
-    while (!WindowShouldClose()) {
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
+    fixed_t px = player->fxPosition.x, py = player->fxPosition.y;
+    fixed_t pw = FxFromFloat(player->rect.width), ph = FxFromFloat(player->rect.height);
+    fixed_t bx = FxFromFloat(block.x), by = FxFromFloat(block.y);
+    fixed_t bw = FxFromFloat(block.width), bh = FxFromFloat(block.height);
 
-        Vector2 mouse = GetMousePosition();
+    if (px >= bx + bw || px + pw <= bx || py >= by + bh || py + ph <= by) {
+        return;
+    }
 
-        // Renderiza plano de fundo
-        DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, DARKBLUE);
-        DrawTexture(initializeTexture, SCREEN_WIDTH / 2 - initializeTexture.width / 2, SCREEN_HEIGHT / 4, WHITE);
+    fixed_t overlapX = (px + pw < bx + bw ? px + pw : bx + bw) - (px > bx ? px : bx);
+    fixed_t overlapY = (py + ph < by + bh ? py + ph : by + bh) - (py > by ? py : by);
 
-        // Renderiza botões
-        DrawButton(start, "Iniciar", mouse, YELLOW, LIGHTGRAY);
-        if (HandleButtonClick(start, mouse)) {
-            return 1;
+    // Resolve com base na menor sobreposicao
+    if (overlapX < overlapY) {
+        player->fxPosition.x += (px < bx) ? -overlapX : overlapX;
+        player->fxVelocity.x = 0;
+        player->velocity.x = 0;
+    } else {
+        player->fxPosition.y += (py < by) ? -overlapY : overlapY;
+        player->fxVelocity.y = 0;
+        player->velocity.y = 0;
+        if (py < by) {
+            player->isGrounded = true;
         }
+    }
 
-        DrawButton(leaderboard, "Placar de pontos", mouse, YELLOW, LIGHTGRAY);
-        if (HandleButtonClick(leaderboard, mouse)) {
-            return 2;
-        }
+    player->position = (Vector2){ FxToFloat(player->fxPosition.x), FxToFloat(player->fxPosition.y) };
+    player->rect.x = player->position.x;
+    player->rect.y = player->position.y;
+}
 
-        DrawButton(exit, "Sair", mouse, YELLOW, LIGHTGRAY);
-        if (HandleButtonClick(exit, mouse)) {
-            return 3;
+const char *PaceModeName(PaceMode mode) {
+    switch (mode) {
+        case PACE_CAP: return "limite";
+        case PACE_VSYNC: return "vsync";
+        case PACE_UNCAPPED: return "livre";
+        default: return "adaptativo";
+    }
+}
+
+// Troca o modo de ritmo. O raylib nunca espera sozinho (SetTargetFPS(0)): a espera fica toda em EndFramePacing
+void SetPaceMode(FramePacer *pacer, PaceMode mode) {
+    pacer->mode = mode;
+    pacer->currentFps = pacer->targetFps;
+    pacer->framesSinceSwitch = 0;
+    SetTargetFPS(0);
+    if (mode == PACE_VSYNC) {
+        SetWindowState(FLAG_VSYNC_HINT);
+    } else {
+        ClearWindowState(FLAG_VSYNC_HINT);
+    }
+}
+
+void InitFramePacer(FramePacer *pacer, PaceMode mode, int targetFps) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->targetFps = targetFps > 0 ? targetFps : 60;
+    pacer->frameStart = GetTime();
+    pacer->pollTime = pacer->frameStart;
+    pacer->frameTime = 1.0f / pacer->targetFps;
+    SetPaceMode(pacer, mode);
+}
+
+// Marca que a simulacao deste frame usou a ultima leitura de eventos, para medir a latencia dela ate a apresentacao
+void FramePacerMarkInput(FramePacer *pacer) {
+    pacer->inputUsed = true;
+}
+
+// Media e desvio padrao (jitter) de um historico
+void PacerStats(const float *values, int count, float *mean, float *deviation) {
+    double sum = 0.0, squares = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+        squares += (double)values[i] * values[i];
+    }
+    *mean = count > 0 ? (float)(sum / count) : 0.0f;
+    double variance = count > 0 ? squares / count - (double)*mean * *mean : 0.0;
+    *deviation = variance > 0.0 ? (float)sqrt(variance) : 0.0f;
+}
+
+// Chamado logo depois de EndDrawing: apresenta o frame, ajusta o limite adaptativo e espera ate o prazo do proximo frame,
+// dormindo a maior parte e girando no final. Com SUPPORT_CUSTOM_FRAME_CONTROL (o raylib tambem precisa ser compilado com ele)
+// a troca de buffers e a leitura de eventos ficam aqui: troca, espera e so entao le a entrada, que chega ao proximo passo sem
+// esperar um frame inteiro. Sem ele o raylib le os eventos dentro de EndDrawing, antes da espera, e a latencia medida inclui a espera
+void EndFramePacing(FramePacer *pacer) {
+#if defined(SUPPORT_CUSTOM_FRAME_CONTROL)
+    SwapScreenBuffer();
+#else
+    pacer->pollTime = GetTime(); // EndDrawing acabou de ler os eventos
+#endif
+    double presented = GetTime();
+    if (pacer->inputUsed) {
+        float latency = (float)(presented - pacer->pollTime);
+        pacer->latency = pacer->latency > 0.0f ? pacer->latency * 0.9f + latency * 0.1f : latency;
+        pacer->inputUsed = false;
+    }
+    float work = (float)(presented - pacer->frameStart);
+
+    if (pacer->mode == PACE_ADAPTIVE && pacer->framesSinceSwitch >= PACER_ADAPT_FRAMES) {
+        float meanWork = 0.0f;
+        for (int i = 1; i <= PACER_ADAPT_FRAMES; i++) {
+            meanWork += pacer->work[(pacer->historyIndex - i + PACER_HISTORY) % PACER_HISTORY];
+        }
+        meanWork /= PACER_ADAPT_FRAMES;
+        float budget = 1.0f / pacer->targetFps;
+        if (pacer->currentFps == pacer->targetFps && meanWork > budget * 0.9f) {
+            pacer->currentFps = pacer->targetFps / 2;   // Frames nao cabem: metade, mas estavel
+            pacer->framesSinceSwitch = 0;
+        } else if (pacer->currentFps != pacer->targetFps && meanWork < budget * 0.6f) {
+            pacer->currentFps = pacer->targetFps;       // Sobra tempo com folga: volta ao limite cheio
+            pacer->framesSinceSwitch = 0;
         }
+    }
 
-        EndDrawing();
+    if (pacer->mode == PACE_CAP || pacer->mode == PACE_ADAPTIVE) {
+        double deadline = pacer->frameStart + 1.0 / pacer->currentFps;
+        double remaining = deadline - GetTime();
+        if (remaining > PACER_SPIN_MARGIN) {
+            WaitTime(remaining - PACER_SPIN_MARGIN);
+        }
+        while (GetTime() < deadline) {
+            // Laco ativo ate o prazo
+        }
     }
 
-    return 0;
+#if defined(SUPPORT_CUSTOM_FRAME_CONTROL)
+    PollInputEvents();
+    pacer->pollTime = GetTime();
+#endif
+
+    double now = GetTime();
+    pacer->frameTime = (float)(now - pacer->frameStart); // GetFrameTime nao e atualizado com controle de frame proprio
+    pacer->intervals[pacer->historyIndex] = pacer->frameTime;
+    pacer->work[pacer->historyIndex] = work;
+    pacer->historyIndex = (pacer->historyIndex + 1) % PACER_HISTORY;
+    if (pacer->historyCount < PACER_HISTORY) pacer->historyCount++;
+    pacer->framesSinceSwitch++;
+    pacer->frameStart = now;
 }
-// Desenha a tela final do jogo, retornando uma telaa de vitória ou derrota
-void DesenhaTelaFinal(void) {
-    while(!IsKeyPressed(KEY_ENTER)) {
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
-        DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, RED);
-        DrawText("YOU FAILED!",(SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT - 30) / 2, 60, WHITE);
-        DrawText("Aperte enter para voltar ao menu", (SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT + 60) / 2, 40, WHITE);
-        // volta para o menu
-        EndDrawing();
+
+// Painel com modo, tempo de frame, jitter, trabalho e latencia de entrada
+void RenderPacerStats(const FramePacer *pacer) {
+    float interval, jitter, work, workDeviation;
+    PacerStats(pacer->intervals, pacer->historyCount, &interval, &jitter);
+    PacerStats(pacer->work, pacer->historyCount, &work, &workDeviation);
+
+    DrawRectangle(SCREEN_WIDTH - 330, 10, 320, 100, Fade(BLACK, 0.6f));
+    DrawText(TextFormat("Ritmo: %s %d fps (F4)", PaceModeName(pacer->mode), pacer->mode == PACE_CAP || pacer->mode == PACE_ADAPTIVE ? pacer->currentFps : 0), SCREEN_WIDTH - 320, 18, 18, WHITE);
+    DrawText(TextFormat("Frame: %.2f ms  jitter: %.2f ms", interval * 1000.0f, jitter * 1000.0f), SCREEN_WIDTH - 320, 40, 18, WHITE);
+    DrawText(TextFormat("Trabalho: %.2f ms", work * 1000.0f), SCREEN_WIDTH - 320, 62, 18, WHITE);
+    DrawText(TextFormat("Entrada ate tela: %.2f ms", pacer->latency * 1000.0f), SCREEN_WIDTH - 320, 84, 18, WHITE);
+}
+
+// Um frame do menu: desenha os botoes e retorna a proxima tela (a propria SCENE_MENU se nada foi clicado)
+int Menu(GameUi *ui) {
+    Texture2D initializeTexture = ui->menuTexture;
+    int next = SCENE_MENU;
+
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+
+    Vector2 mouse = GetMousePosition();
+
+    // Renderiza plano de fundo
+    DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, DARKBLUE);
+    DrawTexture(initializeTexture, SCREEN_WIDTH / 2 - initializeTexture.width / 2, SCREEN_HEIGHT / 4, WHITE);
+
+    // Renderiza botões
+    DrawButton(&ui->start, mouse, YELLOW, LIGHTGRAY);
+    if (HandleButtonClick(&ui->start, mouse)) {
+        next = SCENE_PLAYING;
     }
+
+    DrawButton(&ui->leaderboard, mouse, YELLOW, LIGHTGRAY);
+    if (HandleButtonClick(&ui->leaderboard, mouse)) {
+        next = SCENE_LEADERBOARD;
+    }
+
+    DrawButton(&ui->exit, mouse, YELLOW, LIGHTGRAY);
+    if (HandleButtonClick(&ui->exit, mouse)) {
+        next = SCENE_EXIT;
+    }
+
+    EndDrawing();
+    return next;
+}
+
+// Um frame da tela de derrota, volta para o menu com ENTER
+int DesenhaTelaFinal(void) {
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+    DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, RED);
+    DrawText("YOU FAILED!",(SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT - 30) / 2, 60, WHITE);
+    DrawText("Aperte enter para voltar ao menu", (SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT + 60) / 2, 40, WHITE);
+    EndDrawing();
+
+    return IsKeyPressed(KEY_ENTER) ? SCENE_MENU : SCENE_GAME_OVER; // volta para o menu
 }
 // Colisao entre jogador e inimigo
-void HandlePlayerEnemyCollision(Player* player, Enemy* enemies, int enemyCount, int* currentFrame, float dt) {
+void HandlePlayerEnemyCollision(Player* player, Enemy* enemies, int enemyCount, int* currentFrame, float dt, AudioSystem *audio) {
     for (int i = 0; i < enemyCount; i++) {
         if (CheckCollisionRecs(player->rect, enemies[i].rect) && enemies[i].active) {
             player->health -= 1;
+            PlayEffect(audio, SFX_HURT);
             *currentFrame = 11;
 
             player->position = player->spawnPoint;
@@ -694,10 +2768,11 @@ void HandlePlayerEnemyCollision(Player* player, Enemy* enemies, int enemyCount,
 }
 
 // Caso haja colisão entre jogador e o bloco, e bloco seja O, empurra o jogador para trás de subtrai 1 de sua vida.
-void HandleObstacleCollision(Player *player, Rectangle block) {
+void HandleObstacleCollision(Player *player, Rectangle block, AudioSystem *audio) {
     Vector2 correction = {0, 0};
     if (CheckCollisionWithBlock(player->rect, block, &correction)) {
         player->health -= 1;
+        PlayEffect(audio, SFX_HURT);
 
 
         // Reset player to position from 3 seconds ago
@@ -707,8 +2782,6 @@ void HandleObstacleCollision(Player *player, Rectangle block) {
         // Update player's rect position
         player->rect.x = player->position.x;
         player->rect.y = player->position.y;
-
-        printf("Player health: %d\n", player->health);
     }
 }
 
@@ -758,47 +2831,42 @@ void CriaTop5Jogadores(void) {
     fclose(arq);
 }
 
-// Insere o nome do jogador  (exemplo simples de entrada)
-void InsertName(char strnome[50]) {
-    char nome[MAX_NOME] = {'\0'};
-    char caractere;
-    int contaChars = 0;
+// Um frame da tela de vitoria: le o nome do jogador em ui->nameBuffer, retorna true quando ENTER confirma
+bool InsertName(GameUi *ui) {
+    // Recebe o nome do jogador (todos os caracteres digitados no frame)
+    int caractere;
+    while ((caractere = GetCharPressed()) != 0) {
+        if (ui->nameLength < 23) {
+            ui->nameBuffer[ui->nameLength++] = (char)caractere;
+            ui->nameBuffer[ui->nameLength] = '\0';
+        }
+    }
 
-    while (!IsKeyPressed(KEY_ENTER)) {
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
-        DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
-        DrawText("PARABENS! VOCE GANHOU", (SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT - 30) / 2, 60, GREEN);
-        DrawText("Aperte enter para voltar ao menu", (SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT + 60) / 2, 40, WHITE);
-        // Recebe o nome do jogador
-        caractere = GetCharPressed();
+    if (IsKeyPressed(KEY_BACKSPACE) && ui->nameLength > 0) {
+        ui->nameBuffer[--ui->nameLength] = '\0';
+    }
 
-        if (caractere != '\0' && contaChars < 23) {
-            nome[contaChars] = caractere;
-            contaChars++;
-        }
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+    DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
+    DrawText("PARABENS! VOCE GANHOU", (SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT - 30) / 2, 60, GREEN);
+    DrawText("Aperte enter para voltar ao menu", (SCREEN_WIDTH - MeasureText("PARABENS! VOCE GANHOU", 60)) / 2, (SCREEN_HEIGHT + 60) / 2, 40, WHITE);
+    DrawText(TextFormat("Nome: %s", ui->nameBuffer), 45, 45, 40, RAYWHITE);
+    EndDrawing();
 
-        if (IsKeyPressed(KEY_BACKSPACE)) {
-            nome[contaChars - 1] = '\0';
-            if (contaChars > 0)
-                contaChars--;
-        }
+    return IsKeyPressed(KEY_ENTER);
+}
 
-        DrawText(TextFormat("Nome: %s", nome), 45, 45, 40, RAYWHITE);
-        EndDrawing();
+// Le o placar de top_scores.bin, criando o arquivo com jogadores ficticios se ele nao existir. Retorna false se nao conseguiu ler os 5
+bool CarregaTop5(JogadorLeader Players[5]) {
+    if (!FileExists("top_scores.bin")) {
+        CriaTop5Jogadores();  // Cria o arquivo caso não exista
     }
- strcpy(strnome,nome);
-}
 
-// Desenha uma tela com os top 5 jogadores (exibe a leaderboard)
-void DesenhaTop5(int *guarda) {
-    FILE *arq;
-    JogadorLeader Players[5];
-    int i, j = 0;
-    arq = fopen("top_scores.bin", "rb");
+    FILE *arq = fopen("top_scores.bin", "rb");
     if (!arq) {
         printf("Erro na abertura do arquivo!\n");
-        return;
+        return false;
     }
 
     int bytesRead = fread(Players, sizeof(JogadorLeader), 5, arq);
@@ -806,112 +2874,132 @@ void DesenhaTop5(int *guarda) {
 
     if (bytesRead != 5) {
         printf("Erro ao ler dados do arquivo ou o arquivo está incompleto.\n");
-        return;
+        return false;
     }
+    return true;
+}
 
-    Rectangle exitButton = {SCREEN_WIDTH - 150, 20, 130, 90};
-
-    BeginDrawing();
-    ClearBackground(RAYWHITE);
-    DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
-    DrawText("Leaderboard", (SCREEN_WIDTH / 2 - MeasureText("Leaderboard", 50) / 2), 20, 50, WHITE);
+// Um frame da tela com os top 5 jogadores (leaderboard). O arquivo é lido ao entrar na tela e a tela só é redesenhada se o placar mudar.
+// Sempre desenha um frame, mesmo sem placar, para o ENTER continuar voltando ao menu
+Scene LeaderboardScene(GameUi *ui) {
+    JogadorLeader *Players = ui->top5;
+    int i, j = 0;
 
-    for (i = 0; i < 5; i++) {
-        DrawText(TextFormat("Nome: %s", Players[i].nome), 15, 100 + j, 30, WHITE);
-        DrawText(TextFormat("Pontuacao: %d \n", Players[i].points), 400, 100 + j, 30, WHITE);
-        j += 40;
+    if (!ui->top5Loaded) {
+        ui->top5Error = !CarregaTop5(Players);
+        ui->top5Loaded = true;
     }
 
-    DrawRectangleRec(exitButton, RED);
-    DrawText("Aperte \nenter \npara sair", exitButton.x + 20, exitButton.y + 10, 20, WHITE);
+    unsigned int key = UiHash(ui->top5Error, Players, sizeof(ui->top5));
+    if (UiCacheNeedsRedraw(&ui->leaderboardScreen, key)) {
+        Rectangle exitButton = {SCREEN_WIDTH - 150, 20, 130, 90};
 
-    EndDrawing();
-}
+        UiCacheBegin(&ui->leaderboardScreen, SCREEN_WIDTH, SCREEN_HEIGHT, key);
+        DrawRectangle(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, BLACK);
+        DrawText("Leaderboard", (SCREEN_WIDTH / 2 - MeasureText("Leaderboard", 50) / 2), 20, 50, WHITE);
 
-// Atualiza o leaderboard com o novo jogador e sua pontuação
-void AtualizaTop5(JogadorLeader player1) {
-    FILE *arq;
-    JogadorLeader Players[5];
-    int i, j = 0;
+        if (ui->top5Error) {
+            DrawText("Nao foi possivel ler o placar (top_scores.bin)", 15, 100, 30, RED);
+        } else {
+            for (i = 0; i < 5; i++) {
+                DrawText(TextFormat("Nome: %s", Players[i].nome), 15, 100 + j, 30, WHITE);
+                DrawText(TextFormat("Pontuacao: %d \n", Players[i].points), 400, 100 + j, 30, WHITE);
+                j += 40;
+            }
+        }
 
-    arq = fopen("top_scores.bin", "rb+");
-    if (!arq) {
-        printf("Erro na abertura do arquivo!\n");
-        return;
+        DrawRectangleRec(exitButton, RED);
+        DrawText("Aperte \nenter \npara sair", exitButton.x + 20, exitButton.y + 10, 20, WHITE);
+        UiCacheEnd();
     }
 
-    fread(Players, sizeof(JogadorLeader), 5, arq);
-    OrdenaPlayers(Players);
-    Players[4] = player1;
-    OrdenaPlayers(Players);
-    fwrite(Players, sizeof(JogadorLeader), 5, arq);
-    fclose(arq);
+    BeginDrawing();
+    ClearBackground(RAYWHITE);
+    UiCacheDraw(&ui->leaderboardScreen, 0, 0);
+    EndDrawing();
+
+    if (IsKeyPressed(KEY_ENTER)) {
+        ui->top5Loaded = false; // Relê o arquivo na próxima vez que abrir o placar
+        return SCENE_MENU;
+    }
+    return SCENE_LEADERBOARD;
 }
 
-// Verifica a colisão com o portão e registra a pontuação do jogador
+// Verifica a colisão com o portão e marca que o jogador terminou o nivel
 void HandleGateCollision(Player *player, Rectangle block) {
-    char nomejogador[MAX_NOME];
     Vector2 correction = {0, 0};
-    FILE *arq;
-    JogadorLeader Players[5];
 
     if (CheckCollisionWithBlock(player->rect, block, &correction)) {
-        // Verifica se o arquivo existe
-        arq = fopen("top_scores.bin", "rb");
-        if (!arq) {
-            printf("Arquivo não encontrado. Criando top_scores.bin...\n");
-            CriaTop5Jogadores();
-            arq = fopen("top_scores.bin", "rb"); // Reabre após criação
-        }
+        player->hasFinished = 1;
+    }
+}
 
-        // Lê os jogadores do arquivo
-        fread(Players, sizeof(JogadorLeader), 5, arq);
-        fclose(arq);
+// Registra no placar a pontuação do jogador que chegou ao portão, com o nome digitado na tela de vitória
+void RegistraPontuacao(const char *nomejogador, int points) {
+    JogadorLeader Players[5];
 
-        // Insere o nome do jogador atual
-        InsertName(nomejogador);
+    // Lê os jogadores do arquivo (criado se ainda não existir). Sem placar válido não há o que atualizar
+    if (!CarregaTop5(Players)) {
+        printf("Pontuação de %s não registrada.\n", nomejogador);
+        return;
+    }
 
-        JogadorLeader jogadorAtual;
-        strcpy(jogadorAtual.nome, nomejogador);
-        jogadorAtual.points = player->points;
+    JogadorLeader jogadorAtual;
+    strcpy(jogadorAtual.nome, nomejogador);
+    jogadorAtual.points = points;
 
-        // Adiciona o novo jogador no final do array
-        Players[4] = jogadorAtual;
+    // Adiciona o novo jogador no final do array
+    Players[4] = jogadorAtual;
 
-        // Ordena os jogadores
-        OrdenaPlayers(Players);
+    // Ordena os jogadores
+    OrdenaPlayers(Players);
 
-        // Reabre o arquivo para sobrescrever os dados
-        arq = fopen("top_scores.bin", "wb");
-        if (!arq) {
-            printf("Erro ao abrir top_scores.bin para escrita!\n");
-            return;
-        }
+    // Reabre o arquivo para sobrescrever os dados
+    FILE *arq = fopen("top_scores.bin", "wb");
+    if (!arq) {
+        printf("Erro ao abrir top_scores.bin para escrita!\n");
+        return;
+    }
 
-        fwrite(Players, sizeof(JogadorLeader), 5, arq);
-        fclose(arq);
+    fwrite(Players, sizeof(JogadorLeader), 5, arq);
+    fclose(arq);
 
-        // Exibe mensagem e finaliza o jogo
-        player->hasFinished = 1;
-        printf("Parabéns, %s! Sua pontuação de %d foi registrada.\n", nomejogador, jogadorAtual.points);
-    }
+    // Exibe mensagem
+    printf("Parabéns, %s! Sua pontuação de %d foi registrada.\n", nomejogador, jogadorAtual.points);
 }
 
-// Percorre o array de caracteres (mapa), cria um retangulo e usa CheckCollisionWithBlock() para determinar se o jogador está colidindo com algum bloco.
-void HandlePlayerBlockCollisions(Player *player, char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, float blockSize) {
-    player->isGrounded = false;
+// Testa o jogador contra os retangulos de blocos unidos e percorre as camadas de bits em volta dele para obstaculos e portoes, usando CheckCollisionWithBlock() para determinar se o jogador está colidindo com algum bloco.
+// O movimento em MovePlayer ja para o jogador encostado nos blocos, a correcao aqui so atua se ele ja estiver dentro de um
+void HandlePlayerBlockCollisions(Player *player, const TileFlags *tiles, TileRect solidRects[MAX_MERGED_RECTS], int solidRectCount, float blockSize, bool fixedPoint, AudioSystem *audio) {
+    // Blocos: poucos retangulos grandes, sem emendas entre blocos vizinhos onde o jogador poderia enganchar
+    for (int i = 0; i < solidRectCount; i++) {
+        if (fixedPoint) {
+            HandleBlockCollisionFixed(player, solidRects[i].rect);
+        } else {
+            HandleBlockCollision(player, solidRects[i].rect);
+        }
+    }
 
-    for (int y = 0; y < rows; y++) {
-        for (int x = 0; x < cols; x++) {
+    // Apenas os tiles sob o jogador (com 1 tile de margem para as correcoes) podem colidir
+    int x0 = (int)floorf(player->rect.x / blockSize) - 1;
+    int x1 = (int)floorf((player->rect.x + player->rect.width) / blockSize) + 1;
+    int y0 = (int)floorf(player->rect.y / blockSize) - 1;
+    int y1 = (int)floorf((player->rect.y + player->rect.height) / blockSize) + 1;
+
+    for (int y = y0; y <= y1; y++) {
+        // Pula linhas sem nenhum tile relevante na faixa
+        if (!TileSpanAny(tiles, TILE_HAZARD, y, x0, x1) &&
+                !TileSpanAny(tiles, TILE_GATE, y, x0, x1)) {
+            continue;
+        }
+
+        for (int x = x0; x <= x1; x++) {
             Rectangle block = {x * blockSize, y * blockSize, blockSize, blockSize};
 
-            if (map[y][x] == 'B') {
-                HandleBlockCollision(player, block);
+            if (TileHas(tiles, TILE_HAZARD, x, y)) {
+                HandleObstacleCollision(player, block, audio);
             }
-            else if (map[y][x] == 'O') {
-                HandleObstacleCollision(player, block);
-            }
-            else if (map[y][x] == 'G') {
+            else if (TileHas(tiles, TILE_GATE, x, y)) {
                 HandleGateCollision(player, block);
             }
         }
@@ -919,11 +3007,11 @@ void HandlePlayerBlockCollisions(Player *player, char map[MAX_HEIGHT][MAX_WIDTH]
 }
 
 // Chama todas as funções de colisão 1 vez só
-void HandleCollisions(Player* player, Enemy* enemies, int enemyCount, Projectile projectiles[MAX_PROJECTILES], char map[MAX_HEIGHT][MAX_WIDTH], int rows, int cols, float blockSize, unsigned currentFrame, float dt, Coin coins[MAX_WIDTH], int *coinCount) {
-    HandlePlayerBlockCollisions(player, map, rows, cols, blockSize);
-    HandlePlayerEnemyCollision(player, enemies, enemyCount, &currentFrame, dt);
-    CheckProjectileEnemyCollision(projectiles, &enemyCount, enemies, player);
-    CheckPlayerCoinCollision(player, coins, coinCount);
+void HandleCollisions(Player* player, Enemy* enemies, int enemyCount, Projectile projectiles[MAX_PROJECTILES], const TileFlags *tiles, TileRect solidRects[MAX_MERGED_RECTS], int solidRectCount, float blockSize, bool fixedPoint, unsigned currentFrame, float dt, const Level *level, uint64_t activeCoins[ENTITY_WORDS], AudioSystem *audio, ParticleSystem *particles) {
+    HandlePlayerBlockCollisions(player, tiles, solidRects, solidRectCount, blockSize, fixedPoint, audio);
+    HandlePlayerEnemyCollision(player, enemies, enemyCount, &currentFrame, dt, audio);
+    CheckProjectileEnemyCollision(projectiles, &enemyCount, enemies, player, audio, particles);
+    CheckPlayerCoinCollision(player, level, activeCoins, blockSize, audio, particles);
 }
 
 // Atualiza textura que apresenta o jogador conforme movimento
@@ -948,13 +3036,619 @@ void UpdatePlayerAnimation(Player *player, float *frameTimer, float frameSpeed,
 }
 
 // Atualiza estado do jogador frame a frame e chama a função cada vez para trocar textura de acordo com estado
-void UpdatePlayerAnimationState(Player *player, float *frameTimer, float frameSpeed, unsigned *currentFrame, Rectangle *frameRec, int frameWidth) {
-    *frameTimer += GetFrameTime(); // Pega tempo desde o último frame
+void UpdatePlayerAnimationState(Player *player, float *frameTimer, float frameSpeed, unsigned *currentFrame, Rectangle *frameRec, int frameWidth, float dt) {
+    *frameTimer += dt; // Tempo desde o último frame
     UpdatePlayerAnimation(player, frameTimer, frameSpeed, currentFrame); // Aplica textura ao jogador
     frameRec->x = frameWidth * (*currentFrame);
     frameRec->width = player->facingRight ? -frameWidth : frameWidth;
 }
 
+
+// Liga os count primeiros bits de um conjunto de bits de entidades e desliga o resto
+void FillEntityBits(uint64_t bits[ENTITY_WORDS], int count) {
+    for (int w = 0; w < ENTITY_WORDS; w++) {
+        int first = w * 64;
+        bits[w] = count >= first + 64 ? ~0ULL : count > first ? (1ULL << (count - first)) - 1 : 0;
+    }
+}
+
+// Salva um checkpoint com apenas os inimigos mortos e moedas coletadas ate agora
+void CaptureCheckpoint(LevelCheckpoint *checkpoint, const GameState *state, Vector2 spawnPoint) {
+    checkpoint->active = true;
+    checkpoint->spawnPoint = spawnPoint;
+    checkpoint->points = state->player.points;
+    memset(checkpoint->deadEnemies, 0, sizeof(checkpoint->deadEnemies));
+    memset(checkpoint->takenCoins, 0, sizeof(checkpoint->takenCoins));
+    checkpoint->brokenTiles = state->level->brokenCount;
+
+    for (int i = 0; i < state->enemyCount; i++) {
+        if (!state->enemies[i].active) {
+            checkpoint->deadEnemies[i >> 6] |= 1ULL << (i & 63);
+        }
+    }
+    for (int i = 0; i < state->level->initial.coinCount; i++) {
+        if (!((state->activeCoins[i >> 6] >> (i & 63)) & 1)) {
+            checkpoint->takenCoins[i >> 6] |= 1ULL << (i & 63);
+        }
+    }
+}
+
+// Salva um checkpoint quando o jogador encosta em um tile 'K' diferente do ultimo
+void HandleCheckpointCollision(GameState *state, float blockSize) {
+    Rectangle rect = state->player.rect;
+    int x0 = (int)floorf(rect.x / blockSize);
+    int x1 = (int)ceilf((rect.x + rect.width) / blockSize) - 1;
+    int y0 = (int)floorf(rect.y / blockSize);
+    int y1 = (int)ceilf((rect.y + rect.height) / blockSize) - 1;
+
+    for (int y = y0; y <= y1; y++) {
+        if (!TileSpanAny(state->level->tiles, TILE_CHECKPOINT, y, x0, x1)) continue;
+        for (int x = x0; x <= x1; x++) {
+            if (!TileHas(state->level->tiles, TILE_CHECKPOINT, x, y)) continue;
+
+            Vector2 spawnPoint = {x * blockSize, (y + 1) * blockSize - rect.height};
+            if (state->checkpoint.active && state->checkpoint.spawnPoint.x == spawnPoint.x && state->checkpoint.spawnPoint.y == spawnPoint.y) {
+                return; // Ja e o checkpoint atual
+            }
+            CaptureCheckpoint(&state->checkpoint, state, spawnPoint);
+            state->player.spawnPoint = spawnPoint; // Perder vida agora volta para o checkpoint
+            return;
+        }
+    }
+}
+
+// Carrega o mapa e gera tudo que deriva dele: camadas de bits, retangulos unidos e as entidades iniciais.
+// Libera em bloco tudo do nivel anterior: a arena volta ao inicio e cada vetor e alocado com o tamanho do nivel novo
+bool LoadLevel(Level *level, Arena *arena, const char *fileName, const GameConfig *config) {
+    ArenaReset(arena);
+    memset(level, 0, sizeof(*level));
+    level->arena = arena;
+    level->fileName = ArenaCopyString(arena, fileName);
+
+    // O mapa e lido num bloco do tamanho maximo, que depois encolhe no lugar para as linhas lidas
+    level->map = ArenaAlloc(arena, MAX_HEIGHT * sizeof(level->map[0]));
+    if (!level->fileName || !level->map || !LoadMap(fileName, level->map, &level->rows, &level->cols)) {
+        return false;
+    }
+    level->map = ArenaResize(arena, level->map, MAX_HEIGHT * sizeof(level->map[0]), level->rows * sizeof(level->map[0]));
+    level->mapRows = level->rows;
+
+    level->tiles = ArenaAlloc(arena, sizeof(TileFlags));
+    level->checkpoints = ArenaAlloc(arena, MAX_CHECKPOINTS * sizeof(Vector2));
+    if (!level->tiles || !level->checkpoints || !ResizeTileFlags(level->tiles, arena, level->rows)) {
+        return false;
+    }
+    BuildTileFlags(level->map, level->rows, level->cols, level->tiles);
+    RebuildLevelLayers(level, ((1u << TILE_LAYER_COUNT) - 1) & ~(1u << TILE_COLLECTABLE)); // Moedas depois, o indice precisa do vetor de moedas
+    level->hash = LevelHash(level);
+
+    // Lista suja das trocas de tile e registro dos blocos quebrados, com espaco para quebrar todos os 'D' do mapa
+    int breakables = CountLayerTiles(level->tiles, TILE_BREAKABLE, level->rows);
+    level->brokenCapacity = breakables < MAX_BROKEN_TILES ? breakables : MAX_BROKEN_TILES;
+    level->edits = ArenaAlloc(arena, TILE_EDIT_QUEUE_SIZE * sizeof(TileEdit));
+    level->brokenTiles = ArenaAlloc(arena, level->brokenCapacity * sizeof(uint32_t));
+    level->flowCellCapacity = level->rows * level->cols;
+    level->flowCells = ArenaAlloc(arena, level->flowCellCapacity * sizeof(uint32_t));
+    if (!level->edits || !level->brokenTiles || !level->flowCells) {
+        return false;
+    }
+
+    Player player = InitializePlayer();
+    if (!FindPlayerSpawnPoint(level->map, level->rows, level->cols, &player)) {
+        return false;
+    }
+    LevelSnapshot *initial = &level->initial;
+    initial->spawnPoint = player.spawnPoint;
+    int coins = CountMapTiles(level->map, level->rows, level->cols, 'C');
+    int enemies = CountMapTiles(level->map, level->rows, level->cols, 'M') + CountMapTiles(level->map, level->rows, level->cols, 'F');
+    initial->coinCapacity = coins < MAX_WIDTH ? coins : MAX_WIDTH;
+    initial->enemyCapacity = enemies < MAX_WIDTH ? enemies : MAX_WIDTH;
+    initial->coins = ArenaAlloc(arena, initial->coinCapacity * sizeof(Coin));
+    initial->enemies = ArenaAlloc(arena, initial->enemyCapacity * sizeof(Enemy));
+    level->enemies = ArenaAlloc(arena, initial->enemyCapacity * sizeof(Enemy));
+    if (!initial->coins || !initial->enemies || !level->enemies) {
+        return false;
+    }
+    initial->coinCount = InitializeCoins(level->map, level->rows, level->cols, initial->coins, BLOCK_SIZE);
+    if (!BuildCoinRank(level)) {
+        return false;
+    }
+    initial->enemyCount = InitializeEnemies(
+        level->map, level->rows, level->cols,
+        initial->enemies, BLOCK_SIZE,
+        config->enemySpeedX, config->enemySpeedY, config->enemyOffset
+    );
+
+    PrintArenaUsage(arena, "Memoria do nivel");
+    return true;
+}
+
+// Copia o nivel carregado para outra arena, com as mesmas capacidades, para uma instancia que quebra blocos sem mexer nas outras
+bool CopyLevel(Level *level, Arena *arena, const Level *source) {
+    ArenaReset(arena);
+    *level = *source;
+    level->arena = arena;
+    level->fileName = ArenaCopyString(arena, source->fileName);
+    level->map = ArenaCopy(arena, source->map, source->mapRows * sizeof(source->map[0]));
+    level->tiles = ArenaAlloc(arena, sizeof(TileFlags));
+    if (!level->tiles || !ResizeTileFlags(level->tiles, arena, source->tiles->rows)) {
+        return false;
+    }
+    memcpy(level->tiles->bits[0], source->tiles->bits[0], TILE_LAYER_COUNT * source->tiles->rows * sizeof(source->tiles->bits[0][0]));
+    level->solidRects = ArenaCopy(arena, source->solidRects, source->solidRectCapacity * sizeof(TileRect));
+    level->breakableRect = ArenaCopy(arena, source->breakableRect, source->breakableRectCapacity * sizeof(int16_t));
+    level->hazardRects = ArenaCopy(arena, source->hazardRects, source->hazardRectCapacity * sizeof(TileRect));
+    level->gateRects = ArenaCopy(arena, source->gateRects, source->gateRectCapacity * sizeof(TileRect));
+    level->checkpoints = ArenaCopy(arena, source->checkpoints, MAX_CHECKPOINTS * sizeof(Vector2));
+    level->coinRank = ArenaCopy(arena, source->coinRank, source->coinRankRows * sizeof(source->coinRank[0]));
+    level->edits = ArenaCopy(arena, source->edits, TILE_EDIT_QUEUE_SIZE * sizeof(TileEdit));
+    level->brokenTiles = ArenaCopy(arena, source->brokenTiles, source->brokenCapacity * sizeof(uint32_t));
+    level->flowCells = ArenaAlloc(arena, source->flowCellCapacity * sizeof(uint32_t)); // Cada partida faz o seu campo
+    level->initial.coins = ArenaCopy(arena, source->initial.coins, source->initial.coinCapacity * sizeof(Coin));
+    level->initial.enemies = ArenaCopy(arena, source->initial.enemies, source->initial.enemyCapacity * sizeof(Enemy));
+    level->enemies = ArenaAlloc(arena, source->initial.enemyCapacity * sizeof(Enemy)); // Preenchido pelo ResetLevel
+    return level->fileName && level->map && level->tiles && level->solidRects && level->breakableRect && level->hazardRects &&
+           level->gateRects && level->checkpoints && level->coinRank && level->edits && level->brokenTiles && level->flowCells &&
+           level->initial.coins && level->initial.enemies && level->enemies;
+}
+
+// Reinicia o nivel copiando de volta as entidades iniciais, sem percorrer o mapa. Com checkpoint ativo, reaplica o que tinha mudado ate ele
+void ResetLevel(GameState *state) {
+    const LevelSnapshot *initial = &state->level->initial;
+    if (RestoreBrokenTiles(state->level, state->checkpoint.active ? state->checkpoint.brokenTiles : 0)) {
+        state->flow.originX = -1;
+    }
+    state->enemyCount = initial->enemyCount;
+    memcpy(state->enemies, initial->enemies, initial->enemyCount * sizeof(Enemy));
+    FillEntityBits(state->activeCoins, initial->coinCount);
+    InitializeProjectiles(state->projectiles);
+
+    state->player.health = PLAYER_MAX_HEALTH;
+    state->player.hasFinished = 0;
+    state->player.points = 0;
+    state->player.spawnPoint = initial->spawnPoint;
+
+    const LevelCheckpoint *checkpoint = &state->checkpoint;
+    if (checkpoint->active) {
+        for (int i = 0; i < state->enemyCount; i++) {
+            if ((checkpoint->deadEnemies[i >> 6] >> (i & 63)) & 1) {
+                state->enemies[i].health = 0;
+                state->enemies[i].active = false;
+            }
+        }
+        for (int w = 0; w < ENTITY_WORDS; w++) {
+            state->activeCoins[w] &= ~checkpoint->takenCoins[w];
+        }
+        state->player.points = checkpoint->points;
+        state->player.spawnPoint = checkpoint->spawnPoint;
+    }
+
+    state->player.position = state->player.spawnPoint;
+    state->player.velocity = (Vector2){0, 0};
+    state->player.rect.x = state->player.position.x;
+    state->player.rect.y = state->player.position.y;
+}
+
+// Comeca uma partida do zero no nivel
+void StartGame(GameState *state, Level *level) {
+    state->level = level;
+    state->enemies = level->enemies;
+    state->tickAccumulator = 0.0f;
+    state->player = InitializePlayer();
+    state->checkpoint.active = false;
+    ResetFlowField(&state->flow, level);
+    ResetLevel(state);
+    state->camera = InitializeCamera(&state->player);
+}
+
+// Comeca a observar o arquivo do mapa. No Linux usa inotify na pasta (editores costumam salvar em um arquivo novo e renomear), nos outros sistemas consulta a data de modificacao
+void InitMapWatcher(MapWatcher *watcher, const char *fileName) {
+    watcher->fileName = fileName;
+    watcher->fd = -1;
+    watcher->modTime = GetFileModTime(fileName);
+    watcher->nextPoll = 0.0;
+#ifdef __linux__
+    watcher->fd = inotify_init1(IN_NONBLOCK);
+    if (watcher->fd >= 0 && inotify_add_watch(watcher->fd, ".", IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(watcher->fd);
+        watcher->fd = -1;
+    }
+#endif
+}
+
+// Retorna true se o mapa foi salvo desde a ultima chamada, sem bloquear
+bool MapWatcherChanged(MapWatcher *watcher) {
+#ifdef __linux__
+    if (watcher->fd >= 0) {
+        char buffer[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(watcher->fd, buffer, sizeof(buffer))) > 0) {
+            for (char *ptr = buffer; ptr < buffer + length; ) {
+                const struct inotify_event *event = (const struct inotify_event *)ptr;
+                if (event->len > 0 && strcmp(event->name, watcher->fileName) == 0) {
+                    changed = true;
+                }
+                ptr += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        return changed;
+    }
+#endif
+    double now = GetTime();
+    if (now < watcher->nextPoll) return false;
+    watcher->nextPoll = now + MAP_POLL_INTERVAL;
+
+    long modTime = GetFileModTime(watcher->fileName);
+    if (modTime == watcher->modTime) return false;
+    watcher->modTime = modTime;
+    return true;
+}
+
+void CloseMapWatcher(MapWatcher *watcher) {
+#ifdef __linux__
+    if (watcher->fd >= 0) {
+        close(watcher->fd);
+    }
+#endif
+    watcher->fd = -1;
+}
+
+// Posicao de um tile na ordem de leitura do mapa (linha por linha), a mesma em que inimigos e moedas sao criados
+int TileOrder(Vector2 position, float blockSize) {
+    return (int)(position.y / blockSize) * MAX_WIDTH + (int)(position.x / blockSize);
+}
+
+// Abre (insert) ou fecha a posicao index de um conjunto de bits de entidades, deslocando os bits seguintes junto com o vetor
+void ShiftEntityBits(uint64_t bits[ENTITY_WORDS], int index, int count, bool insert) {
+    if (insert) {
+        for (int i = count; i > index; i--) {
+            uint64_t bit = (bits[(i - 1) >> 6] >> ((i - 1) & 63)) & 1;
+            bits[i >> 6] = (bits[i >> 6] & ~(1ULL << (i & 63))) | (bit << (i & 63));
+        }
+        bits[index >> 6] &= ~(1ULL << (index & 63));
+    } else {
+        for (int i = index; i < count - 1; i++) {
+            uint64_t bit = (bits[(i + 1) >> 6] >> ((i + 1) & 63)) & 1;
+            bits[i >> 6] = (bits[i >> 6] & ~(1ULL << (i & 63))) | (bit << (i & 63));
+        }
+        bits[(count - 1) >> 6] &= ~(1ULL << ((count - 1) & 63));
+    }
+}
+
+// Cria ou remove o inimigo do tile (x, y) no estado inicial do nivel e na partida em andamento, que usam os mesmos indices
+void PatchLevelEnemy(GameState *state, int x, int y, bool spawn, EnemyKind kind, const GameConfig *config) {
+    LevelSnapshot *initial = &state->level->initial;
+    int key = y * MAX_WIDTH + x;
+    int count = initial->enemyCount;
+    int index = 0;
+    while (index < count && TileOrder(initial->enemies[index].minPosition, BLOCK_SIZE) < key) {
+        index++;
+    }
+
+    if (spawn) {
+        if (count == initial->enemyCapacity) {
+            // Vetores cheios: o inicial e o da partida crescem na arena, os blocos antigos voltam junto com o nivel
+            Level *level = state->level;
+            int capacity = count * 2 + 8 < MAX_WIDTH ? count * 2 + 8 : MAX_WIDTH;
+            Enemy *grown = count < MAX_WIDTH ? ArenaResize(level->arena, initial->enemies, count * sizeof(Enemy), capacity * sizeof(Enemy)) : NULL;
+            Enemy *grownLive = grown ? ArenaResize(level->arena, level->enemies, count * sizeof(Enemy), capacity * sizeof(Enemy)) : NULL;
+            if (grown) initial->enemies = grown;
+            if (!grownLive) return;
+            level->enemies = grownLive;
+            state->enemies = grownLive;
+            initial->enemyCapacity = capacity;
+        }
+        Enemy enemy = CreateEnemy(x, y, kind, BLOCK_SIZE, config->enemySpeedX, config->enemySpeedY, config->enemyOffset);
+        memmove(&initial->enemies[index + 1], &initial->enemies[index], (count - index) * sizeof(Enemy));
+        memmove(&state->enemies[index + 1], &state->enemies[index], (count - index) * sizeof(Enemy));
+        initial->enemies[index] = enemy;
+        state->enemies[index] = enemy;
+        ShiftEntityBits(state->checkpoint.deadEnemies, index, count, true);
+        count++;
+    } else {
+        if (index == count || TileOrder(initial->enemies[index].minPosition, BLOCK_SIZE) != key) return;
+        memmove(&initial->enemies[index], &initial->enemies[index + 1], (count - index - 1) * sizeof(Enemy));
+        memmove(&state->enemies[index], &state->enemies[index + 1], (count - index - 1) * sizeof(Enemy));
+        ShiftEntityBits(state->checkpoint.deadEnemies, index, count, false);
+        count--;
+    }
+
+    initial->enemyCount = count;
+    state->enemyCount = count;
+}
+
+// Cria ou remove a moeda do tile (x, y), como PatchLevelEnemy
+void PatchLevelCoin(GameState *state, int x, int y, bool spawn) {
+    LevelSnapshot *initial = &state->level->initial;
+    int key = y * MAX_WIDTH + x;
+    int count = initial->coinCount;
+    int index = 0;
+    while (index < count && TileOrder(initial->coins[index].position, BLOCK_SIZE) < key) {
+        index++;
+    }
+
+    if (spawn) {
+        if (count == MAX_WIDTH) {
+            // Limite atingido: ficam as MAX_WIDTH primeiras na ordem de leitura, como no LoadLevel, para o indice por tile (CoinAt) continuar valendo
+            if (index == count) return;
+            count--;
+        } else if (count == initial->coinCapacity) {
+            int capacity = count * 2 + 8 < MAX_WIDTH ? count * 2 + 8 : MAX_WIDTH;
+            Coin *grown = ArenaResize(state->level->arena, initial->coins, count * sizeof(Coin), capacity * sizeof(Coin));
+            if (!grown) return;
+            initial->coins = grown;
+            initial->coinCapacity = capacity;
+        }
+        Coin coin = CreateCoin(x, y, BLOCK_SIZE);
+        memmove(&initial->coins[index + 1], &initial->coins[index], (count - index) * sizeof(Coin));
+        initial->coins[index] = coin;
+        ShiftEntityBits(state->activeCoins, index, count, true);
+        state->activeCoins[index >> 6] |= 1ULL << (index & 63);
+        ShiftEntityBits(state->checkpoint.takenCoins, index, count, true);
+        count++;
+    } else {
+        if (index == count || TileOrder(initial->coins[index].position, BLOCK_SIZE) != key) return;
+        memmove(&initial->coins[index], &initial->coins[index + 1], (count - index - 1) * sizeof(Coin));
+        ShiftEntityBits(state->activeCoins, index, count, false);
+        ShiftEntityBits(state->checkpoint.takenCoins, index, count, false);
+        count--;
+    }
+
+    initial->coinCount = count;
+}
+
+// Recarrega o mapa com o jogo rodando: compara a grade nova com a atual e aplica so os tiles que mudaram, sem reiniciar a partida
+bool HotReloadLevel(GameState *state, const char *fileName, const GameConfig *config) {
+    static char map[MAX_HEIGHT][MAX_WIDTH]; // Estatico: grande demais para a pilha
+    Level *level = state->level;
+    double start = GetTime();
+
+    memset(map, 0, sizeof(map));
+    int rows, cols;
+    if (!LoadMap(fileName, map, &rows, &cols)) {
+        printf("Mapa nao recarregado, o nivel atual continua\n"); // Arquivo salvo pela metade ou invalido
+        return false;
+    }
+
+    // Mapa ganhou linhas: a grade cresce na arena, com as linhas novas zeradas como as que nao foram lidas
+    if (rows > level->mapRows) {
+        char (*grown)[MAX_WIDTH] = ArenaResize(level->arena, level->map, level->mapRows * sizeof(level->map[0]), rows * sizeof(level->map[0]));
+        if (!grown) {
+            printf("Mapa nao recarregado, o nivel atual continua\n");
+            return false;
+        }
+        level->map = grown;
+        level->mapRows = rows;
+    }
+    if (rows * cols > level->flowCellCapacity) {
+        uint32_t *grown = ArenaResize(level->arena, level->flowCells, level->flowCellCapacity * sizeof(uint32_t), rows * cols * sizeof(uint32_t));
+        if (!grown) {
+            printf("Mapa nao recarregado, o nivel atual continua\n");
+            return false;
+        }
+        level->flowCells = grown;
+        level->flowCellCapacity = rows * cols;
+    }
+    if (rows > level->tiles->rows && !ResizeTileFlags(level->tiles, level->arena, rows)) {
+        printf("Mapa nao recarregado, o nivel atual continua\n");
+        return false;
+    }
+
+    level->editCount = 0; // Trocas pendentes valiam para o mapa antigo
+    int maxRows = rows > level->rows ? rows : level->rows;
+    unsigned layers = 0;
+    int changedTiles = 0;
+    bool spawnChanged = false;
+
+    // So os tiles dentro de rows x cols viram camadas e entidades, como no LoadLevel. Se o tamanho mudou, tiles de fora podem entrar ou sair sem o caractere mudar
+    bool resized = rows != level->rows || cols != level->cols;
+    for (int y = 0; y < maxRows; y++) {
+        if (!resized && memcmp(map[y], level->map[y], MAX_WIDTH) == 0) continue; // Linha inteira igual
+        for (int x = 0; x < MAX_WIDTH; x++) {
+            char oldTile = y < level->rows && x < level->cols ? level->map[y][x] : '\0';
+            char newTile = y < rows && x < cols ? map[y][x] : '\0';
+            if (oldTile == newTile) continue;
+
+            if (EnemyKindOf(oldTile) >= 0) PatchLevelEnemy(state, x, y, false, EnemyKindOf(oldTile), config);
+            if (oldTile == 'C') PatchLevelCoin(state, x, y, false);
+            layers |= SetTileLayers(level->tiles, x, y, oldTile, newTile);
+            if (EnemyKindOf(newTile) >= 0) PatchLevelEnemy(state, x, y, true, EnemyKindOf(newTile), config);
+            if (newTile == 'C') PatchLevelCoin(state, x, y, true);
+
+            spawnChanged |= oldTile == 'P' || newTile == 'P';
+            changedTiles++;
+        }
+        memcpy(level->map[y], map[y], MAX_WIDTH);
+    }
+
+    // Mapa mudou de tamanho: os dados derivados percorrem rows x cols, entao todos sao refeitos
+    if (resized) {
+        level->rows = rows;
+        level->cols = cols;
+        layers = (1u << TILE_LAYER_COUNT) - 1;
+    }
+    RebuildLevelLayers(level, layers);
+    if (resized) {
+        ResetFlowField(&state->flow, level); // Celulas indexadas por cols: o campo antigo nao vale mais
+    } else if (layers & (1u << TILE_SOLID)) {
+        state->flow.originX = -1; // Caminhos mudaram, refaz o campo de fluxo no proximo frame
+    }
+
+    // Blocos quebrados voltaram com o arquivo: o registro recomeca (e cresce se o mapa ganhou 'D') e o quicksave passa a valer para o mapa novo
+    level->brokenCount = 0;
+    state->checkpoint.brokenTiles = 0;
+    level->hash = LevelHash(level);
+    int breakables = CountLayerTiles(level->tiles, TILE_BREAKABLE, level->rows);
+    if (breakables > MAX_BROKEN_TILES) breakables = MAX_BROKEN_TILES;
+    if (breakables > level->brokenCapacity) {
+        uint32_t *grown = ArenaResize(level->arena, level->brokenTiles, level->brokenCapacity * sizeof(uint32_t), breakables * sizeof(uint32_t));
+        if (grown) {
+            level->brokenTiles = grown;
+            level->brokenCapacity = breakables;
+        }
+    }
+
+    // Novo 'P' vale para o proximo respawn, o jogador nao e teleportado
+    Player player = InitializePlayer();
+    if (spawnChanged && FindPlayerSpawnPoint(level->map, level->rows, level->cols, &player)) {
+        level->initial.spawnPoint = player.spawnPoint;
+        if (!state->checkpoint.active) {
+            state->player.spawnPoint = player.spawnPoint;
+        }
+    }
+
+    printf("Mapa recarregado: %d tiles alterados em %.2f ms\n", changedTiles, (GetTime() - start) * 1000.0);
+    PrintArenaUsage(level->arena, "Memoria do nivel");
+    return true;
+}
+
+// Buffer do quicksave: cabecalho, parte fixa e, no pior caso, todos os inimigos, projeteis e blocos quebrados
+static unsigned char saveBuffer[sizeof(SaveHeader) + sizeof(SaveState) + MAX_WIDTH * sizeof(SavedEnemy) + MAX_PROJECTILES * sizeof(Projectile) +
+    MAX_BROKEN_TILES * sizeof(uint32_t)] __attribute__((aligned(16)));
+
+// Grava a partida em um arquivo com uma unica escrita. Inimigos mortos e moedas coletadas viram bits, so inimigos vivos e projeteis ativos sao gravados inteiros
+bool SaveGame(const GameState *state, const char *fileName) {
+    SaveState *save = (SaveState *)(saveBuffer + sizeof(SaveHeader));
+    memset(save, 0, sizeof(*save));
+    save->levelHash = state->level->hash;
+    save->enemyCount = state->enemyCount;
+    save->coinCount = state->level->initial.coinCount;
+    save->player = state->player;
+    save->camera = state->camera;
+    save->frameTimer = state->frameTimer;
+    save->frameTimerEnemies = state->frameTimerEnemies;
+    save->currentFrame = state->currentFrame;
+    save->currentEnemyFrame = state->currentEnemyFrame;
+    save->checkpoint = state->checkpoint;
+
+    SavedEnemy *enemies = (SavedEnemy *)(save + 1);
+    for (int i = 0; i < state->enemyCount; i++) {
+        const Enemy *enemy = &state->enemies[i];
+        if (!enemy->active) {
+            save->deadEnemies[i >> 6] |= 1ULL << (i & 63);
+            continue;
+        }
+        enemies[save->liveEnemyCount++] = (SavedEnemy){
+            i, enemy->health, enemy->position, enemy->velocity, enemy->fxPosition, enemy->fxVelocity
+        };
+    }
+    for (int i = 0; i < state->level->initial.coinCount; i++) {
+        if (!((state->activeCoins[i >> 6] >> (i & 63)) & 1)) {
+            save->takenCoins[i >> 6] |= 1ULL << (i & 63);
+        }
+    }
+
+    Projectile *projectiles = (Projectile *)(enemies + save->liveEnemyCount);
+    for (int i = 0; i < MAX_PROJECTILES; i++) {
+        if (state->projectiles[i].active) {
+            projectiles[save->projectileCount++] = state->projectiles[i];
+        }
+    }
+
+    uint32_t *broken = (uint32_t *)(projectiles + save->projectileCount);
+    save->brokenCount = state->level->brokenCount;
+    memcpy(broken, state->level->brokenTiles, save->brokenCount * sizeof(uint32_t));
+
+    size_t bodySize = (unsigned char *)(broken + save->brokenCount) - (unsigned char *)save;
+    SaveHeader *header = (SaveHeader *)saveBuffer;
+    memcpy(header->magic, "INFS", 4);
+    header->version = SAVE_VERSION;
+    header->size = (uint32_t)bodySize;
+    header->checksum = SaveChecksum(save, bodySize);
+
+    FILE *file = fopen(fileName, "wb");
+    if (!file) {
+        perror("Erro ao gravar o quicksave");
+        return false;
+    }
+    size_t written = fwrite(saveBuffer, 1, sizeof(SaveHeader) + bodySize, file);
+    fclose(file);
+    return written == sizeof(SaveHeader) + bodySize;
+}
+
+// Carrega o quicksave com uma unica leitura. So altera a partida se versao, tamanho, checksum e nivel baterem
+bool LoadGame(GameState *state, const char *fileName) {
+    FILE *file = fopen(fileName, "rb");
+    if (!file) {
+        return false;
+    }
+    size_t size = fread(saveBuffer, 1, sizeof(saveBuffer), file);
+    fclose(file);
+
+    const SaveHeader *header = (const SaveHeader *)saveBuffer;
+    const SaveState *save = (const SaveState *)(saveBuffer + sizeof(SaveHeader));
+    if (size < sizeof(SaveHeader) + sizeof(SaveState) || memcmp(header->magic, "INFS", 4) != 0 ||
+            header->version != SAVE_VERSION || header->size != size - sizeof(SaveHeader) ||
+            header->checksum != SaveChecksum(save, header->size)) {
+        printf("Quicksave invalido ou de outra versao\n");
+        return false;
+    }
+    Level *level = state->level;
+    if (save->levelHash != level->hash ||
+            save->enemyCount != state->level->initial.enemyCount || save->coinCount != state->level->initial.coinCount ||
+            save->liveEnemyCount < 0 || save->liveEnemyCount > save->enemyCount ||
+            save->projectileCount < 0 || save->projectileCount > MAX_PROJECTILES ||
+            save->brokenCount < 0 || save->brokenCount > level->brokenCapacity ||
+            header->size != sizeof(SaveState) + save->liveEnemyCount * sizeof(SavedEnemy) + save->projectileCount * sizeof(Projectile) +
+                save->brokenCount * sizeof(uint32_t)) {
+        printf("Quicksave de outro mapa\n");
+        return false;
+    }
+
+    // Parte do estado inicial do nivel e aplica as diferencas gravadas
+    const LevelSnapshot *initial = &level->initial;
+    state->enemyCount = initial->enemyCount;
+    memcpy(state->enemies, initial->enemies, initial->enemyCount * sizeof(Enemy));
+    FillEntityBits(state->activeCoins, initial->coinCount);
+
+    for (int i = 0; i < state->enemyCount; i++) {
+        if ((save->deadEnemies[i >> 6] >> (i & 63)) & 1) {
+            state->enemies[i].health = 0;
+            state->enemies[i].active = false;
+        }
+    }
+    const SavedEnemy *enemies = (const SavedEnemy *)(save + 1);
+    for (int i = 0; i < save->liveEnemyCount; i++) {
+        if (enemies[i].index < 0 || enemies[i].index >= state->enemyCount) continue;
+        Enemy *enemy = &state->enemies[enemies[i].index];
+        enemy->health = enemies[i].health;
+        enemy->position = enemies[i].position;
+        enemy->velocity = enemies[i].velocity;
+        enemy->fxPosition = enemies[i].fxPosition;
+        enemy->fxVelocity = enemies[i].fxVelocity;
+        enemy->rect.x = enemy->position.x;
+        enemy->rect.y = enemy->position.y;
+    }
+    for (int w = 0; w < ENTITY_WORDS; w++) {
+        state->activeCoins[w] &= ~save->takenCoins[w];
+    }
+
+    InitializeProjectiles(state->projectiles);
+    const Projectile *projectiles = (const Projectile *)(enemies + save->liveEnemyCount);
+    memcpy(state->projectiles, projectiles, save->projectileCount * sizeof(Projectile));
+
+    // Remonta todos os blocos e quebra de novo os do registro, na mesma ordem
+    const uint32_t *broken = (const uint32_t *)(projectiles + save->projectileCount);
+    RestoreBrokenTiles(level, 0);
+    for (int i = 0; i < save->brokenCount; i++) {
+        int x = broken[i] & 0xFFFF;
+        int y = broken[i] >> 16;
+        if (x < level->cols && y < level->rows && level->map[y][x] == 'D') EditLevelTile(level, x, y, ' ');
+    }
+    CommitLevelEdits(level);
+    state->flow.originX = -1;
+
+    state->player = save->player;
+    state->camera = save->camera;
+    state->frameTimer = save->frameTimer;
+    state->frameTimerEnemies = save->frameTimerEnemies;
+    state->currentFrame = save->currentFrame;
+    state->currentEnemyFrame = save->currentEnemyFrame;
+    state->checkpoint = save->checkpoint;
+    return true;
+}
+
 // Verifica vida do jogador e, se abaixo de 0, encerra o jogo
 int isPlayerDead(Player player) {
     if (player.health <= -1) {
@@ -972,86 +3666,410 @@ int hasPlayerFinishedTheGame(Player player) {
     }
 }
 
-int BeginGame(GameConfig *config, GameAssets *assets, GameState *state) {
-    float dt = GetFrameTime();
+// Avanca a partida em um passo: movimento, tiros e colisoes. Nao desenha nem le o teclado, entao tambem roda sem janela
+// particles pode ser NULL, como audio, quando ninguem vai desenhar
+void SimulateGame(GameState *state, const GameConfig *config, PlayerInput input, float dt, AudioSystem *audio, ParticleSystem *particles) {
+    Level *level = state->level;
+
+    if (config->fixedPoint) {
+        MovePlayerFixed(&state->player, input, config, level->tiles, dt);
+        MoveEnemiesFixed(state->enemies, state->enemyCount, dt);
+        MoveProjectilesFixed(state->projectiles, dt, &state->player, SCREEN_WIDTH, level, particles);
+    } else {
+        MovePlayer(&state->player, input, config, level->tiles, dt);
+        MoveEnemies(state->enemies, state->enemyCount, dt);
+        MoveProjectiles(state->projectiles, dt, &state->player, SCREEN_WIDTH, level, BLOCK_SIZE, particles);
+    }
+    MoveFlyers(state->enemies, state->enemyCount, &state->flow, level->tiles, state->player.rect, config->enemySpeedY, BLOCK_SIZE, dt);
+
+    CreateProjectile(&state->player, input, state->projectiles, config->projectileWidth, config->projectileHeight, config->projectileSpeed, dt, audio);
+    HandleCollisions(
+        &state->player, state->enemies, state->enemyCount,
+        state->projectiles, level->tiles,
+        level->solidRects, level->solidRectCount,
+        BLOCK_SIZE, config->fixedPoint, state->currentFrame, dt, level, state->activeCoins, audio, particles
+    );
+    HandleCheckpointCollision(state, BLOCK_SIZE);
+
+    // Blocos quebrados neste frame: colisao e desenho atualizados so nos tiles trocados
+    if (CommitLevelEdits(level) & (1u << TILE_SOLID)) {
+        state->flow.originX = -1; // Caminhos mudaram, o campo de fluxo e refeito
+    }
+}
 
-    ApplyGravity(&state->player, config->gravity, dt);
+int BeginGame(GameConfig *config, GameAssets *assets, GameState *state, AudioSystem *audio, ParticleSystem *particles, GameUi *ui, FramePacer *pacer) {
+    float dt = pacer->frameTime;
 
     if (hasPlayerFinishedTheGame(state->player)) {
         UpdatePlayerAnimationState(
             &state->player, &state->frameTimer,
             config->frameSpeed, &state->currentFrame,
-            &assets->playerFrameRec, assets->playerFrameWidth
+            &assets->playerFrameRec, assets->playerFrameWidth, dt
         );
 
-        MovePlayer(&state->player, config->playerSpeed, config->jumpForce, dt);
-        MoveCamera(&state->camera, &state->player);
-        MoveEnemies(state->enemies, state->enemyCount, dt);
-        MoveProjectiles(state->projectiles, dt, &state->player, SCREEN_WIDTH, state->map, state->rows, state->cols, BLOCK_SIZE);
+        // Quicksave: F5 grava, F9 volta para o ultimo gravado
+        if (IsKeyPressed(KEY_F5) || IsKeyPressed(KEY_F9)) {
+            double start = GetTime();
+            bool saving = IsKeyPressed(KEY_F5);
+            bool ok = saving ? SaveGame(state, SAVE_FILE) : LoadGame(state, SAVE_FILE);
+            if (ok) {
+                if (!saving) ClearParticles(particles);
+                printf("%s em %.3f ms\n", saving ? "Jogo salvo" : "Jogo carregado", (GetTime() - start) * 1000.0);
+            }
+        }
 
-        CreateProjectile(&state->player, state->projectiles, config->projectileWidth, config->projectileHeight, config->projectileSpeed, dt);
-        HandleCollisions(
-            &state->player, state->enemies, state->enemyCount,
-            state->projectiles, state->map, state->rows, state->cols,
-            BLOCK_SIZE, state->currentFrame, dt, state->coins, &state->coinCount
-        );
+        // Simulacao em passos fixos, independente da taxa de frames: cada passo consome a fila de entrada. Para ao terminar ou morrer
+        FramePacerMarkInput(pacer);
+        double now = GetTime();
+        CollectInputEvents(&state->input, now);
+        state->tickAccumulator += dt;
+        int ticks = 0;
+        while (state->tickAccumulator >= SIM_TICK && ticks < SIM_MAX_TICKS && hasPlayerFinishedTheGame(state->player)) {
+            SimulateGame(state, config, ReadPlayerInput(&state->input, now), SIM_TICK, audio, particles);
+            state->tickAccumulator -= SIM_TICK;
+            ticks++;
+        }
+        if (ticks == SIM_MAX_TICKS && state->tickAccumulator >= SIM_TICK) {
+            state->tickAccumulator = 0.0f; // Atraso demais: descarta em vez de correr para alcancar
+        }
+        UpdateParticles(particles, dt, config->gravity * 0.5f);
+        MoveCamera(&state->camera, &state->player);
+        UpdateEnemyAnimationState(&state->frameTimerEnemies, 0.5f, &state->currentEnemyFrame, &assets->enemyFrameRec, 16, dt); // Relogio unico para todos os inimigos
 
         BeginDrawing();
         ClearBackground(RAYWHITE);
 
         BeginMode2D(state->camera);
 
-        RenderBackground(assets->background, state->rows, state->cols);
+        RenderBackground(assets->background, state->level->rows, state->level->cols);
 
         DrawTexturePro(
             assets->playerTexture, assets->playerFrameRec,
             state->player.rect, (Vector2){0, 0}, 0.0f, WHITE
         );
-        RenderCoins(state->coins, state->coinCount);
+        RenderCoins(state->level, state->activeCoins, BLOCK_SIZE, GetCameraView(state->camera));
         RenderMap(
-            state->map, state->rows, state->cols,
-            BLOCK_SIZE, assets->blockTexture,
+            state->level, &state->checkpoint, BLOCK_SIZE, assets->blockTexture,
             assets->obstacleTexture, assets->gateTexture
         );
         RenderProjectiles(state->projectiles);
         RenderEnemies(
             state->enemies, state->enemyCount, BLOCK_SIZE,
-            assets->enemiesTexture, &assets->enemyFrameRec,
-            &state->frameTimerEnemies, &state->currentEnemyFrame
+            assets->enemiesTexture, assets->enemyFrameRec,
+            state->currentEnemyFrame, GetCameraView(state->camera)
         );
+        RenderParticles(particles, GetCameraView(state->camera));
 
         EndMode2D();
 
-        RenderHUD(state->player.health, assets->heartTexture, state->player.points);
+        RenderHUD(state->player.health, assets->heartTexture, state->player.points, &ui->hud);
+        if (pacer->showStats) {
+            RenderPacerStats(pacer);
+        }
 
         EndDrawing();
-        state->guarda = 1;
+        state->guarda = SCENE_PLAYING;
+    } else {
+        if(isPlayerDead(state->player)) {
+            PlayEffect(audio, SFX_DEATH);
+            state->guarda = SCENE_GAME_OVER;
+        } else {
+            // Pontos guardados para quando o nome for confirmado na tela de vitoria
+            ui->pendingPoints = state->player.points;
+            ui->nameBuffer[0] = '\0';
+            ui->nameLength = 0;
+            state->guarda = SCENE_NAME_ENTRY;
+            state->checkpoint.active = false; // Terminou o nivel: a proxima partida comeca do inicio
+        }
+
+        // Morreu: continua do ultimo checkpoint, se tiver
+        ResetLevel(state);
+        ClearParticles(particles);
+    }
+    return 0;
+}
+
+// Resultado de uma partida simulada por um bot
+typedef enum {
+    SIM_TIMEOUT,        // Acabou o tempo sem chegar ao portao (possivel trava)
+    SIM_GATE,           // Chegou ao portao
+    SIM_GAME_OVER,      // Perdeu todas as vidas
+    SIM_FELL            // Caiu para fora do mapa, o jogo nao tem como voltar
+} SimOutcome;
+
+typedef struct {
+    SimOutcome outcome;
+    int deaths;         // Vidas perdidas
+    int score;
+    float timeToGate;   // Segundos ate o portao, negativo se nao chegou
+    float maxX;         // Maior distancia alcancada, mostra onde os bots travam
+    int ticks;
+} SimResult;
+
+// Estado do bot de uma instancia
+typedef struct {
+    uint32_t rng;       // Gerador xorshift, semente diferente por instancia
+    int leftTicks;      // Passos restantes andando para a esquerda
+} SimBot;
+
+// Parte das instancias simulada por uma thread
+typedef struct {
+    const Level *source;        // Nivel carregado, cada thread joga numa copia propria
+    const GameConfig *config;
+    SimResult *results;
+    int first;
+    int last;
+    int maxTicks;
+    float dt;
+    pthread_t thread;
+} SimWorker;
+
+uint32_t SimRandom(uint32_t *state) {
+    uint32_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Bot simples: anda para a direita, pula diante de paredes, buracos, espinhos e inimigos e atira, com um pouco de aleatoriedade por instancia
+PlayerInput BotInput(const GameState *state, SimBot *bot) {
+    const Level *level = state->level;
+    const Player *player = &state->player;
+    PlayerInput input = {0};
+
+    if (bot->leftTicks > 0) {
+        bot->leftTicks--;
+        input.left = true;
     } else {
-        state->guarda = 0;
+        input.right = true;
+        if (SimRandom(&bot->rng) % 200 == 0) {
+            bot->leftTicks = 10 + SimRandom(&bot->rng) % 30;
+        }
+    }
 
-        int test = InitializeEnemies(state->map, state->rows, state->cols, state->enemies, BLOCK_SIZE, config->enemySpeedX, config->enemySpeedY, config->enemyOffset);
-        int teste = InitializeCoins(state->map, state->rows, state->cols, state->coins, BLOCK_SIZE);
+    // Celulas a frente do jogador e abaixo dos pes
+    int ahead = (int)floorf((input.right ? player->rect.x + player->rect.width + 4 : player->rect.x - 4) / BLOCK_SIZE);
+    int top = (int)floorf(player->rect.y / BLOCK_SIZE);
+    int feet = (int)ceilf((player->rect.y + player->rect.height) / BLOCK_SIZE) - 1;
+
+    int step = input.right ? 1 : -1;
+    bool wall = false;
+    bool hazard = false;
+    for (int y = top; y <= feet + 1; y++) {
+        if (y <= feet && TileHas(level->tiles, TILE_SOLID, ahead, y)) wall = true;
+        for (int x = 0; x < 3; x++) {
+            if (TileHas(level->tiles, TILE_HAZARD, ahead + x * step, y)) hazard = true;
+        }
+    }
+    bool gap = !TileHas(level->tiles, TILE_SOLID, ahead, feet + 1);
 
-        if(isPlayerDead(state->player)) {
-            DesenhaTelaFinal();
+    bool enemyAhead = false;
+    for (int i = 0; i < state->enemyCount && !enemyAhead; i++) {
+        float dx = state->enemies[i].position.x - player->position.x;
+        enemyAhead = state->enemies[i].active && fabsf(state->enemies[i].position.y - player->position.y) < 48 &&
+                     (player->facingRight ? dx > 0 && dx < 120 : dx < 0 && dx > -120);
+    }
+
+    input.jump = player->isGrounded && (wall || gap || hazard || enemyAhead || SimRandom(&bot->rng) % 60 == 0); // Aperta so no chao, como uma pessoa: com o buffer de pulo, apertar no ar pularia de novo ao pousar
+    input.shoot = enemyAhead || SimRandom(&bot->rng) % 30 == 0;
+    input.shootVertical = SimRandom(&bot->rng) % 120 == 0;
+    return input;
+}
+
+// Joga as instancias da faixa uma de cada vez ate o portao, fim de jogo ou fim do tempo. Cada thread tem seu proprio GameState
+void *SimWorkerThread(void *arg) {
+    SimWorker *worker = arg;
+    GameState *state = malloc(sizeof(GameState));
+    if (!state) return NULL;
+    Level level;
+    Arena arena;
+    if (!InitArena(&arena, LEVEL_ARENA_SIZE)) {
+        free(state);
+        return NULL;
+    }
+    if (!CopyLevel(&level, &arena, worker->source)) {
+        FreeArena(&arena);
+        free(state);
+        return NULL;
+    }
+
+    for (int i = worker->first; i < worker->last; i++) {
+        SimResult *result = &worker->results[i];
+        SimBot bot = { 2463534242u ^ (uint32_t)(i * 2654435761u), 0 };
+        if (bot.rng == 0) bot.rng = 1;
+
+        memset(state, 0, sizeof(*state));
+        StartGame(state, &level);
+        result->outcome = SIM_TIMEOUT;
+        result->timeToGate = -1.0f;
+        result->maxX = state->player.position.x;
+        float fallLimit = (level.rows + 4) * BLOCK_SIZE;
+
+        int tick;
+        for (tick = 0; tick < worker->maxTicks; tick++) {
+            int health = state->player.health;
+            SimulateGame(state, worker->config, BotInput(state, &bot), worker->dt, NULL, NULL);
+
+            if (state->player.health < health) result->deaths += health - state->player.health;
+            if (state->player.position.x > result->maxX) result->maxX = state->player.position.x;
+
+            if (isPlayerDead(state->player)) {
+                result->outcome = SIM_GAME_OVER;
+                break;
+            }
+            if (state->player.hasFinished) {
+                result->outcome = SIM_GATE;
+                result->timeToGate = (tick + 1) * worker->dt;
+                break;
+            }
+            if (state->player.position.y > fallLimit) {
+                result->outcome = SIM_FELL;
+                break;
+            }
+        }
+        result->ticks = tick < worker->maxTicks ? tick + 1 : tick;
+        result->score = state->player.points;
+    }
+
+    FreeArena(&arena);
+    free(state);
+    return NULL;
+}
+
+// Carrega o nivel uma vez e simula varias partidas com bots em paralelo, sem janela, para validar o nivel. A assinatura dos resultados vai para *signatureOut se nao for NULL
+int RunBatchSimulation(const GameConfig *config, const char *mapFile, int instances, float seconds, int threads, uint32_t *signatureOut) {
+    static Level level;
+    Arena arena;
+    if (!InitArena(&arena, LEVEL_ARENA_SIZE)) {
+        return 1;
+    }
+    if (!LoadLevel(&level, &arena, mapFile, config)) {
+        FreeArena(&arena);
+        return 1;
+    }
+    if (instances < 1) instances = 1;
+    if (threads < 1) threads = 1;
+    if (threads > instances) threads = instances;
+
+    SimResult *results = calloc(instances, sizeof(SimResult));
+    SimWorker *workers = calloc(threads, sizeof(SimWorker));
+    if (!results || !workers) {
+        free(results);
+        free(workers);
+        FreeArena(&arena);
+        return 1;
+    }
+
+    float dt = 1.0f / 60.0f;
+    printf("Simulando %d instancias de ate %.0f s em %d threads (fisica em %s)...\n", instances, seconds, threads,
+           config->fixedPoint ? "ponto fixo" : "float");
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        workers[t].source = &level;
+        workers[t].config = config;
+        workers[t].results = results;
+        workers[t].first = instances * t / threads;
+        workers[t].last = instances * (t + 1) / threads;
+        workers[t].maxTicks = (int)(seconds / dt);
+        workers[t].dt = dt;
+        if (pthread_create(&workers[t].thread, NULL, SimWorkerThread, &workers[t]) != 0) {
+            // Sem thread nova: a thread principal simula o resto das instancias, os resultados nao dependem da divisao
+            printf("Erro ao criar a thread %d, simulando as instancias restantes na thread principal\n", t);
+            workers[t].last = instances;
+            SimWorkerThread(&workers[t]);
+            break;
         }
+        started++;
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t].thread, NULL);
+    }
 
-        state->player.health = 3;
-        state->player.hasFinished = 0;
-        state->player.points = 0;
-        state->player.position= state->player.spawnPoint;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    const char *outcomeNames[] = { "tempo", "portao", "fim_de_jogo", "caiu" };
+    int outcomeCounts[4] = {0};
+    long long totalTicks = 0;
+    double gateTime = 0.0;
+    uint32_t signature = 2166136261u; // FNV-1a dos resultados, para comparar execucoes de builds e maquinas diferentes
+
+    printf("%-8s %-12s %6s %6s %12s %8s\n", "inst", "resultado", "mortes", "pontos", "tempo_portao", "max_x");
+    for (int i = 0; i < instances; i++) {
+        printf("%-8d %-12s %6d %6d %12.2f %8.0f\n", i, outcomeNames[results[i].outcome], results[i].deaths,
+               results[i].score, results[i].timeToGate, results[i].maxX);
+        outcomeCounts[results[i].outcome]++;
+        totalTicks += results[i].ticks;
+        if (results[i].outcome == SIM_GATE) gateTime += results[i].timeToGate;
+
+        uint32_t maxXBits;
+        memcpy(&maxXBits, &results[i].maxX, sizeof(maxXBits));
+        uint32_t fields[5] = { results[i].outcome, results[i].deaths, results[i].score, results[i].ticks, maxXBits };
+        for (int f = 0; f < 5; f++) {
+            signature = (signature ^ fields[f]) * 16777619u;
+        }
+    }
 
-        WaitTime(0.1);
+    printf("\n%lld instancias-ticks em %.3f s = %.0f instancias-ticks/s\n", totalTicks, elapsed, elapsed > 0 ? totalTicks / elapsed : 0.0);
+    printf("portao: %d, fim de jogo: %d, caiu: %d, tempo esgotado: %d\n",
+           outcomeCounts[SIM_GATE], outcomeCounts[SIM_GAME_OVER], outcomeCounts[SIM_FELL], outcomeCounts[SIM_TIMEOUT]);
+    if (outcomeCounts[SIM_GATE] > 0) {
+        printf("tempo medio ate o portao: %.2f s\n", gateTime / outcomeCounts[SIM_GATE]);
     }
+    printf("assinatura dos resultados: %08x\n", signature);
+    if (signatureOut) *signatureOut = signature;
+
+    free(results);
+    free(workers);
+    FreeArena(&arena);
     return 0;
 }
 
-int main(void) {
-    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "INF-MAN");
+// Cenario do --verificar: mapa, modo de fisica e a assinatura gravada de SIM_VERIFY_INSTANCES partidas de SIM_VERIFY_SECONDS
+typedef struct {
+    const char *mapFile;
+    bool fixedPoint;
+    uint32_t signature;
+} SimScenario;
+
+#define SIM_VERIFY_INSTANCES 64
+#define SIM_VERIFY_SECONDS 20.0f
+
+// map_teste.txt tem voadores ('F'), blocos quebraveis ('D') e checkpoints ('K') no caminho dos bots, que map.txt nao tem.
+// Uma mudanca de comportamento intencional precisa gravar as assinaturas novas aqui
+static const SimScenario simScenarios[] = {
+    { "map.txt",       false, 0x7fb55b78u },
+    { "map.txt",       true,  0xfb674daeu },
+    { "map_teste.txt", false, 0xd2fb8a74u },
+    { "map_teste.txt", true,  0x6b9ef807u },
+};
+
+// Roda todos os cenarios gravados e compara as assinaturas. Retorna 1 se algum cenario nao rodou ou mudou de resultado
+int VerifySimulations(const GameConfig *config, int threads) {
+    int failures = 0;
+    int count = sizeof(simScenarios) / sizeof(simScenarios[0]);
+    for (int i = 0; i < count; i++) {
+        GameConfig scenarioConfig = *config;
+        scenarioConfig.fixedPoint = simScenarios[i].fixedPoint;
+        uint32_t signature = 0;
+        bool ok = RunBatchSimulation(&scenarioConfig, simScenarios[i].mapFile, SIM_VERIFY_INSTANCES, SIM_VERIFY_SECONDS, threads, &signature) == 0 &&
+                  signature == simScenarios[i].signature;
+        printf("\n%s (%s): %08x, esperado %08x: %s\n\n", simScenarios[i].mapFile, simScenarios[i].fixedPoint ? "ponto fixo" : "float",
+               signature, simScenarios[i].signature, ok ? "ok" : "FALHOU");
+        failures += !ok;
+    }
+    printf("%d de %d cenarios conferem\n", count - failures, count);
+    return failures > 0;
+}
 
-    InitAudioDevice();
-    Music music = LoadMusicStream("musica_jogo.wav");
-    PlayMusicStream(music);
+int main(int argc, char **argv) {
+    // Todos os caminhos de assets sao relativos a pasta do executavel, nao a pasta de onde o jogo foi aberto
+    ChangeDirectory(GetApplicationDirectory());
 
     GameConfig config = {
         .gravity = 800.0,
@@ -1063,33 +4081,88 @@ int main(void) {
         .projectileWidth = 20.0,
         .projectileHeight = 10.0,
         .projectileSpeed = 400.0,
-        .frameSpeed = 0.15f
+        .frameSpeed = 0.15f,
+        .maxSubstepTime = 1.0f / 120.0f,
+        .maxSubsteps = 8,
+        .jumpBufferTime = 0.1f,
+        .coyoteTime = 0.08f,
+        .fixedPoint = false
     };
 
-    GameState state = { .guarda = 0 };
-    LoadMap("map.txt", state.map, &state.rows, &state.cols);
-    if (state.rows == 0 || state.cols == 0) {
-        CloseWindow();
-        return 1;
+    // --fixo em qualquer posicao liga a fisica em ponto fixo, no jogo e no --simular
+    // --ritmo limite|vsync|livre|adaptativo escolhe o controle de ritmo dos frames, --fps N o limite
+    // --mapa arquivo troca o mapa do --simular
+    PaceMode paceMode = PACE_CAP;
+    int targetFps = 60;
+    const char *mapFile = "map.txt";
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--fixo") == 0) {
+            config.fixedPoint = true;
+        }
+        if (strcmp(argv[i], "--ritmo") == 0 && i + 1 < argc) {
+            for (int m = 0; m < PACE_MODE_COUNT; m++) {
+                if (strcmp(argv[i + 1], PaceModeName(m)) == 0) paceMode = m;
+            }
+        }
+        if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc) {
+            targetFps = atoi(argv[i + 1]);
+        }
+        if (strcmp(argv[i], "--mapa") == 0 && i + 1 < argc) {
+            mapFile = argv[i + 1];
+        }
     }
 
-    state.player = InitializePlayer();
-    if (!FindPlayerSpawnPoint(state.map, state.rows, state.cols, &state.player)) {
+    if (argc > 1 && strcmp(argv[1], "--bake") == 0) {
+        return BakeAssets(PAK_FILE);
+    }
+    if (argc > 1 && strcmp(argv[1], "--simular") == 0) {
+        // --simular [instancias] [segundos] [threads] [--fixo] [--mapa arquivo]
+        int instances = argc > 2 ? atoi(argv[2]) : 1000;
+        float seconds = argc > 3 ? atof(argv[3]) : 60.0f;
+        int threads = argc > 4 ? atoi(argv[4]) : 4;
+        return RunBatchSimulation(&config, mapFile, instances, seconds, threads, NULL);
+    }
+    if (argc > 1 && strcmp(argv[1], "--verificar") == 0) {
+        // --verificar [threads]: confere os cenarios gravados em simScenarios
+        return VerifySimulations(&config, argc > 2 ? atoi(argv[2]) : 4);
+    }
+
+    InitWindow(SCREEN_WIDTH, SCREEN_HEIGHT, "INF-MAN");
+    double startupTime = GetTime();
+
+    AssetPak pak = LoadAssetPak(PAK_FILE);
+
+    InitAudioDevice();
+    AudioSystem audio;
+    InitAudioSystem(&audio, LoadGameMusic(&pak, "musica_jogo.wav")); // Musica e efeitos tocam na thread de audio
+
+    static Level level;                       // Estaticos: grandes demais para a pilha de main
+    static Arena levelArena;                  // Dona de todos os dados do nivel, reservada uma vez e reaproveitada a cada LoadLevel
+    static GameState state = { .guarda = SCENE_MENU };
+    static ParticleSystem particles;            // Pool fixo, nenhuma particula e alocada durante o jogo
+    ClearParticles(&particles);
+    if (!InitArena(&levelArena, LEVEL_ARENA_SIZE) || !LoadLevel(&level, &levelArena, "map.txt", &config)) {
+        FreeArena(&levelArena);
+        CloseAudioSystem(&audio);
         CloseWindow();
         return 1;
     }
 
     GameAssets assets = {
-        .background = LoadTexture("background.png"),
-        .blockTexture = LoadTexture("tile1.png"),
-        .obstacleTexture = LoadTexture("spike.png"),
-        .gateTexture = LoadTexture("gate.png"),
-        .enemiesTexture = LoadTexture("enemies.png"),
-        .heartTexture = LoadTexture("heart.png"),
-        .playerTexture = LoadTexture("inf_man.png")
+        .background = LoadGameTexture(&pak, "background.png"),
+        .blockTexture = LoadGameTexture(&pak, "tile1.png"),
+        .obstacleTexture = LoadGameTexture(&pak, "spike.png"),
+        .gateTexture = LoadGameTexture(&pak, "gate.png"),
+        .enemiesTexture = LoadGameTexture(&pak, "enemies.png"),
+        .heartTexture = LoadGameTexture(&pak, "heart.png"),
+        .playerTexture = LoadGameTexture(&pak, "inf_man.png")
     };
+    // Retangulos unidos repetem a textura do tile ao longo da area
+    SetTextureWrap(assets.blockTexture, TEXTURE_WRAP_REPEAT);
+    SetTextureWrap(assets.obstacleTexture, TEXTURE_WRAP_REPEAT);
 
     InitializePlayerTextureAndAnimation(
+        &pak,
         &assets.playerTexture,
         &assets.playerFrameRec,
         &assets.playerFrameWidth,
@@ -1098,49 +4171,71 @@ int main(void) {
         &assets.enemyFrameWidth
     );
 
-    state.camera = InitializeCamera(&state.player);
-    state.coinCount = InitializeCoins(state.map, state.rows, state.cols, state.coins, BLOCK_SIZE);
-    state.enemyCount = InitializeEnemies(
-        state.map, state.rows, state.cols,
-        state.enemies, BLOCK_SIZE,
-        config.enemySpeedX, config.enemySpeedY, config.enemyOffset
-    );
-    InitializeProjectiles(state.projectiles);
+    GameUi ui;
+    InitGameUi(&ui, &pak);
+
+    // Tempo de inicializacao, para comparar com e sem o pacote de assets
+    printf("Inicializacao em %.1f ms (assets de %s)\n", (GetTime() - startupTime) * 1000.0, pak.data ? PAK_FILE : "arquivos PNG/WAV");
+
+    StartGame(&state, &level);
 
-    SetTargetFPS(60);
+    MapWatcher mapWatcher;
+    InitMapWatcher(&mapWatcher, level.fileName); // Salvar o mapa com o jogo aberto aplica as mudancas na hora
+
+    FramePacer pacer;
+    InitFramePacer(&pacer, paceMode, targetFps);
 
     while (!WindowShouldClose()) {
-        UpdateMusicStream(music);
-        float dt = GetFrameTime();
+        if (MapWatcherChanged(&mapWatcher)) {
+            HotReloadLevel(&state, level.fileName, &config);
+        }
+        if (IsKeyPressed(KEY_F3)) {
+            pacer.showStats = !pacer.showStats;
+        }
+        if (IsKeyPressed(KEY_F4)) {
+            SetPaceMode(&pacer, (pacer.mode + 1) % PACE_MODE_COUNT);
+            printf("Ritmo dos frames: %s\n", PaceModeName(pacer.mode));
+        }
+        // Uma tela por frame: o laco principal nunca fica preso em uma tela, entao o observador do mapa, o audio e o ritmo dos frames continuam em todas
         switch (state.guarda) {
-            case 0:
-                state.guarda = Menu();
+            case SCENE_MENU:
+                state.guarda = Menu(&ui);
                 break;
-            case 1:
-                BeginGame(&config, &assets, &state);
+            case SCENE_PLAYING:
+                BeginGame(&config, &assets, &state, &audio, &particles, &ui, &pacer);
                 break;
-            case 2:
-                    FILE *arq = fopen("top_scores.bin", "rb");
-                    if (!arq) {
-                        CriaTop5Jogadores();  // Cria o arquivo caso não exista
-                    }
-                    else {
-                        DesenhaTop5(&state.guarda);// Exibe o leaderboard
-                        if(IsKeyPressed(KEY_ENTER)) {
-                            state.guarda = 0;
-                        } else {
-                            state.guarda = 2;
-                        }
-                    }
-                    break;
-            case 3:
-                StopMusicStream(music);
+            case SCENE_LEADERBOARD:
+                state.guarda = LeaderboardScene(&ui);
+                break;
+            case SCENE_GAME_OVER:
+                state.guarda = DesenhaTelaFinal();
+                break;
+            case SCENE_NAME_ENTRY:
+                if (InsertName(&ui)) {
+                    RegistraPontuacao(ui.nameBuffer, ui.pendingPoints);
+                    state.guarda = SCENE_MENU;
+                }
+                break;
+            case SCENE_EXIT:
+                CloseMapWatcher(&mapWatcher);
+                FreeArena(&levelArena);
+                UnloadGameUi(&ui);
+                CloseAudioSystem(&audio);
+                UnloadAssetPak(&pak);
                 CloseAudioDevice();
                 CloseWindow();
                 return 0;
         }
+
+        EndFramePacing(&pacer); // Espera o prazo do frame conforme o modo de ritmo
     }
 
+    CloseMapWatcher(&mapWatcher);
+    FreeArena(&levelArena);
+    UnloadGameUi(&ui);
+    CloseAudioSystem(&audio);
+    UnloadAssetPak(&pak);
+    CloseAudioDevice();
     CloseWindow();
     return 0;
 }